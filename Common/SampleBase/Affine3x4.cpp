@@ -0,0 +1,109 @@
+//***************************************************************************************
+// Affine3x4.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "Affine3x4.h"
+
+using namespace DirectX;
+
+namespace
+{
+    // Row r of the stored 3x4 is column r of the 4x4 row-vector matrix.
+    inline XMVECTOR LoadRow( const Affine3x4& a, int r )
+    {
+        return XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( a.m[r] ) );
+    }
+
+    inline void StoreRow( Affine3x4& a, int r, FXMVECTOR v )
+    {
+        XMStoreFloat4( reinterpret_cast<XMFLOAT4*>( a.m[r] ), v );
+    }
+} // namespace
+
+XMVECTOR XM_CALLCONV Affine3x4::TransformPoint( FXMVECTOR p ) const
+{
+    XMVECTOR p1 = XMVectorSetW( p, 1.0f );
+    XMVECTOR x  = XMVector4Dot( LoadRow( *this, 0 ), p1 );
+    XMVECTOR y  = XMVector4Dot( LoadRow( *this, 1 ), p1 );
+    XMVECTOR z  = XMVector4Dot( LoadRow( *this, 2 ), p1 );
+    return XMVectorSet( XMVectorGetX( x ), XMVectorGetX( y ), XMVectorGetX( z ), 1.0f );
+}
+
+XMVECTOR XM_CALLCONV Affine3x4::TransformVector( FXMVECTOR v ) const
+{
+    XMVECTOR x = XMVector3Dot( LoadRow( *this, 0 ), v );
+    XMVECTOR y = XMVector3Dot( LoadRow( *this, 1 ), v );
+    XMVECTOR z = XMVector3Dot( LoadRow( *this, 2 ), v );
+    return XMVectorSet( XMVectorGetX( x ), XMVectorGetX( y ), XMVectorGetX( z ), 0.0f );
+}
+
+Affine3x4 Affine3x4::Multiply( const Affine3x4& a, const Affine3x4& b )
+{
+    // In column-vector form the product is B * A with an implicit (0, 0, 0, 1) bottom row,
+    // so each result row is a combination of the rows of A plus the translation of B.
+    XMVECTOR a0 = LoadRow( a, 0 );
+    XMVECTOR a1 = LoadRow( a, 1 );
+    XMVECTOR a2 = LoadRow( a, 2 );
+
+    const XMVECTOR translationMask = XMVectorSelectControl( 0, 0, 0, 1 );
+
+    Affine3x4 c;
+    for ( int r = 0; r < 3; ++r )
+    {
+        XMVECTOR br = LoadRow( b, r );
+
+        XMVECTOR v = XMVectorAndInt( br, translationMask );
+        v          = XMVectorMultiplyAdd( XMVectorSplatX( br ), a0, v );
+        v          = XMVectorMultiplyAdd( XMVectorSplatY( br ), a1, v );
+        v          = XMVectorMultiplyAdd( XMVectorSplatZ( br ), a2, v );
+        StoreRow( c, r, v );
+    }
+    return c;
+}
+
+Affine3x4 Affine3x4::Inverse( const Affine3x4& a )
+{
+    // Linear part L (columns a0, a1, a2 of the row-vector matrix) and translation t.
+    XMVECTOR a0 = LoadRow( a, 0 );
+    XMVECTOR a1 = LoadRow( a, 1 );
+    XMVECTOR a2 = LoadRow( a, 2 );
+    XMVECTOR t  = XMVectorSet( a.m[0][3], a.m[1][3], a.m[2][3], 0.0f );
+
+    // inverse(L) has the cross products of the rows of L as its columns.
+    XMVECTOR c0  = XMVector3Cross( a1, a2 );
+    XMVECTOR c1  = XMVector3Cross( a2, a0 );
+    XMVECTOR c2  = XMVector3Cross( a0, a1 );
+    XMVECTOR det = XMVector3Dot( a0, c0 );
+
+    XMMATRIX inv    = XMMatrixTranspose( XMMATRIX( c0, c1, c2, XMVectorZero() ) );
+    XMVECTOR invDet = XMVectorReciprocal( det );
+
+    Affine3x4 b;
+    for ( int r = 0; r < 3; ++r )
+    {
+        XMVECTOR row = XMVectorMultiply( inv.r[r], invDet );
+
+        // Translation of the inverse is -inverse(L) * t.
+        row = XMVectorSetW( row, -XMVectorGetX( XMVector3Dot( row, t ) ) );
+        StoreRow( b, r, row );
+    }
+    return b;
+}
+
+void Affine3x4::Pack( const XMFLOAT4X4* in, size_t inStrideInBytes, size_t count,
+                      Affine3x4* out, size_t outStrideInBytes )
+{
+    const BYTE* src = reinterpret_cast<const BYTE*>( in );
+    BYTE*       dst = reinterpret_cast<BYTE*>( out );
+    for ( size_t i = 0; i < count; ++i, src += inStrideInBytes, dst += outStrideInBytes )
+    {
+        XMMATRIX M = XMMatrixTranspose( XMLoadFloat4x4( reinterpret_cast<const XMFLOAT4X4*>( src ) ) );
+
+        Affine3x4& a = *reinterpret_cast<Affine3x4*>( dst );
+        StoreRow( a, 0, M.r[0] );
+        StoreRow( a, 1, M.r[1] );
+        StoreRow( a, 2, M.r[2] );
+    }
+}
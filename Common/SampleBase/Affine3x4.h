@@ -0,0 +1,62 @@
+//***************************************************************************************
+// Affine3x4.h
+//
+// Compact affine transform for per-object constant data.
+//
+// The last column of an affine row-vector matrix is always (0, 0, 0, 1), so only 48 of
+// its 64 bytes need to be uploaded.  Affine3x4 stores the matrix transposed, with
+// translation in the 4th column, exactly like XMFLOAT3X4.  On the HLSL side declare it
+// as float4x3 (default column-major packing) and use it as a row-vector transform:
+//
+//     float3 posW = mul( float4( posL, 1.0f ), gWorld );
+//
+// The same 48 bytes work in constant buffers and in structured buffers.
+//***************************************************************************************
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+
+struct Affine3x4 : public DirectX::XMFLOAT3X4
+{
+    Affine3x4() = default;
+
+    // Drops the last column of M, which is assumed to be (0, 0, 0, 1).
+    explicit Affine3x4( DirectX::FXMMATRIX M )
+    {
+        Store( M );
+    }
+
+    static Affine3x4 Identity()
+    {
+        return Affine3x4( DirectX::XMMatrixIdentity() );
+    }
+
+    // To and from the equivalent 4x4 row-vector matrix.
+    DirectX::XMMATRIX XM_CALLCONV Load() const
+    {
+        return DirectX::XMLoadFloat3x4( this );
+    }
+
+    void XM_CALLCONV Store( DirectX::FXMMATRIX M )
+    {
+        DirectX::XMStoreFloat3x4( this, M );
+    }
+
+    DirectX::XMVECTOR XM_CALLCONV TransformPoint( DirectX::FXMVECTOR p ) const;
+    DirectX::XMVECTOR XM_CALLCONV TransformVector( DirectX::FXMVECTOR v ) const;
+
+    // Transform that applies a first, then b (same order as XMMatrixMultiply( a, b )).
+    static Affine3x4 Multiply( const Affine3x4& a, const Affine3x4& b );
+
+    // Inverse through the 3x3 cofactor matrix.  a must not be singular.
+    static Affine3x4 Inverse( const Affine3x4& a );
+
+    // Packs count 4x4 matrices, e.g. the World member of an object constant array
+    // (with the struct size as stride), into mapped constant or structured buffer memory.
+    static void Pack( const DirectX::XMFLOAT4X4* in, size_t inStrideInBytes, size_t count,
+                      Affine3x4* out, size_t outStrideInBytes = sizeof( DirectX::XMFLOAT3X4 ) );
+};
+
+static_assert( sizeof( Affine3x4 ) == 48, "Affine3x4 must match the HLSL float4x3 layout." );
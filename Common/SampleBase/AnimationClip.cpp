@@ -0,0 +1,451 @@
+//***************************************************************************************
+// AnimationClip.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "AnimationClip.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    const std::uint32_t MaxFrames = 1 << 14;
+
+    const float Sqrt2    = 1.41421356f;
+    const float InvSqrt2 = 0.70710678f;
+
+    XMVECTOR NLerp( FXMVECTOR a, FXMVECTOR b, float t )
+    {
+        // Blend along the shorter arc.
+        XMVECTOR b1 = XMVectorGetX( XMVector4Dot( a, b ) ) < 0.0f ? XMVectorNegate( b ) : b;
+        return XMQuaternionNormalize( XMVectorLerp( a, b1, t ) );
+    }
+
+    float Vec3Error( FXMVECTOR a, FXMVECTOR b )
+    {
+        return XMVectorGetX( XMVector3Length( XMVectorSubtract( a, b ) ) );
+    }
+
+    // Angle of the rotation between two unit quaternions.  Computed from the chord between
+    // them rather than acos of their dot product, which is too coarse near 1 to resolve
+    // tolerances of a few milliradians.
+    float QuatError( FXMVECTOR a, FXMVECTOR b )
+    {
+        XMVECTOR d     = XMVectorGetX( XMVector4Dot( a, b ) ) < 0.0f ? XMVectorAdd( a, b ) : XMVectorSubtract( a, b );
+        float    chord = XMVectorGetX( XMVector4Length( d ) );
+        return 4.0f * asinf( std::min<float>( 0.5f * chord, 1.0f ) );
+    }
+
+    // Longest run of frames one pair of keys may span.  Every candidate end re-checks the
+    // frames of its segment, so this bounds the reduction to O(frames * MaxKeySpan).
+    const size_t MaxKeySpan = 64;
+
+    std::uint16_t QuantizeUNorm16( float x )
+    {
+        x = x > 0.0f ? ( x < 1.0f ? x : 1.0f ) : 0.0f;
+        return (std::uint16_t)( x * 65535.0f + 0.5f );
+    }
+
+    std::int16_t QuantizeSNorm16( float x )
+    {
+        x = x > -1.0f ? ( x < 1.0f ? x : 1.0f ) : -1.0f;
+        x *= 32767.0f;
+        return (std::int16_t)( x + ( x < 0.0f ? -0.5f : 0.5f ) );
+    }
+
+    // Translation and scale: each component relative to the range of the channel.
+    void QuantizeVec3( FXMVECTOR v, FXMVECTOR vmin, FXMVECTOR invRange, std::uint16_t out[3] )
+    {
+        XMFLOAT3 n;
+        XMStoreFloat3( &n, XMVectorMultiply( XMVectorSubtract( v, vmin ), invRange ) );
+        out[0] = QuantizeUNorm16( n.x );
+        out[1] = QuantizeUNorm16( n.y );
+        out[2] = QuantizeUNorm16( n.z );
+    }
+
+    void DequantizeVec3( const std::uint16_t v[3], const XMFLOAT3& min, const XMFLOAT3& extent, float out[3] )
+    {
+        const float scale = 1.0f / 65535.0f;
+        out[0]            = min.x + v[0] * scale * extent.x;
+        out[1]            = min.y + v[1] * scale * extent.y;
+        out[2]            = min.z + v[2] * scale * extent.z;
+    }
+
+    // Rotation: drops the largest component and returns its index; the other three lie in
+    // [-1/sqrt2, 1/sqrt2].  q and -q are the same rotation, so the sign is flipped to make
+    // the dropped component positive.
+    int QuantizeQuat( FXMVECTOR q, std::int16_t out[3] )
+    {
+        XMFLOAT4 f;
+        XMStoreFloat4( &f, q );
+        float c[4] = { f.x, f.y, f.z, f.w };
+
+        int largest = 0;
+        for ( int i = 1; i < 4; ++i )
+        {
+            if ( fabsf( c[i] ) > fabsf( c[largest] ) )
+                largest = i;
+        }
+        float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+
+        for ( int i = 0, j = 0; i < 4; ++i )
+        {
+            if ( i != largest )
+                out[j++] = QuantizeSNorm16( c[i] * sign * Sqrt2 );
+        }
+        return largest;
+    }
+
+    void DequantizeQuat( int largest, const std::int16_t v[3], float out[4] )
+    {
+        float sumSq = 0.0f;
+        for ( int i = 0, j = 0; i < 4; ++i )
+        {
+            if ( i == largest )
+                continue;
+            float c = v[j++] * ( InvSqrt2 / 32767.0f );
+            out[i]  = c;
+            sumSq += c * c;
+        }
+        out[largest] = sqrtf( std::max<float>( 0.0f, 1.0f - sumSq ) );
+    }
+
+    ///<summary>
+    /// Greedy keyframe reduction.  Starting from a kept frame, extends the segment as far as
+    /// linear interpolation between its end points reproduces every frame in between within
+    /// tolerance, up to MaxKeySpan frames.  The end points come from loadKey, which returns
+    /// a frame as it decodes after quantization, so the tolerance bounds the error of the
+    /// stored keys rather than of the source frames.  Returns the kept frame numbers; the
+    /// first and last frames are always kept.
+    ///</summary>
+    template <typename LoadFn, typename LoadKeyFn, typename LerpFn, typename ErrorFn>
+    std::vector<std::uint32_t> ReduceKeys( size_t frameCount, float tolerance, LoadFn load, LoadKeyFn loadKey,
+                                           LerpFn lerp, ErrorFn error )
+    {
+        std::vector<std::uint32_t> kept( 1, 0 );
+
+        size_t start = 0;
+        while ( start + 1 < frameCount )
+        {
+            size_t   end  = start + 1;
+            size_t   last = std::min<size_t>( frameCount - 1, start + MaxKeySpan );
+            XMVECTOR a    = loadKey( start );
+            for ( size_t candidate = start + 2; candidate <= last; ++candidate )
+            {
+                XMVECTOR b    = loadKey( candidate );
+                float    span = (float)( candidate - start );
+
+                bool fits = true;
+                for ( size_t k = start + 1; k < candidate && fits; ++k )
+                    fits = error( lerp( a, b, ( k - start ) / span ), load( k ) ) <= tolerance;
+
+                if ( !fits )
+                    break;
+                end = candidate;
+            }
+
+            kept.push_back( (std::uint32_t)end );
+            start = end;
+        }
+
+        return kept;
+    }
+
+    // Segment of a channel around frame: keys [i, i+1] and the blend factor.  Past the
+    // last key both indices point at it.
+    template <typename Key, typename FrameFn>
+    void FindSegment( const Key* keys, std::uint32_t keyCount, float frame, FrameFn frameOf,
+                      std::uint32_t& i0, std::uint32_t& i1, float& t )
+    {
+        const Key* it = std::upper_bound( keys, keys + keyCount, frame,
+                                          [&]( float f, const Key& k ) { return f < (float)frameOf( k ); } );
+
+        std::uint32_t next = (std::uint32_t)( it - keys );
+        if ( next == 0 )
+        {
+            i0 = i1 = 0;
+            t       = 0.0f;
+        }
+        else if ( next == keyCount )
+        {
+            i0 = i1 = keyCount - 1;
+            t       = 0.0f;
+        }
+        else
+        {
+            i0       = next - 1;
+            i1       = next;
+            float f0 = (float)frameOf( keys[i0] );
+            float f1 = (float)frameOf( keys[i1] );
+            t        = ( frame - f0 ) / ( f1 - f0 );
+        }
+    }
+
+    // Number of tracks blended per SIMD operation.
+    const size_t Lanes = 4;
+
+    // Decoded keys of Lanes tracks, component-major so each row loads as one XMVECTOR.
+    struct alignas( 16 ) Vec3Block
+    {
+        float A[3][Lanes];
+        float B[3][Lanes];
+        float T[Lanes];
+    };
+
+    struct alignas( 16 ) QuatBlock
+    {
+        float A[4][Lanes];
+        float B[4][Lanes];
+        float T[Lanes];
+    };
+
+    void BlendVec3( const Vec3Block& in, float out[3][Lanes] )
+    {
+        XMVECTOR t = XMLoadFloat4A( reinterpret_cast<const XMFLOAT4A*>( in.T ) );
+        for ( int c = 0; c < 3; ++c )
+        {
+            XMVECTOR a = XMLoadFloat4A( reinterpret_cast<const XMFLOAT4A*>( in.A[c] ) );
+            XMVECTOR b = XMLoadFloat4A( reinterpret_cast<const XMFLOAT4A*>( in.B[c] ) );
+            XMStoreFloat4A( reinterpret_cast<XMFLOAT4A*>( out[c] ), XMVectorMultiplyAdd( XMVectorSubtract( b, a ), t, a ) );
+        }
+    }
+
+    void BlendQuat( const QuatBlock& in, float out[4][Lanes] )
+    {
+        XMVECTOR a[4], b[4];
+        for ( int c = 0; c < 4; ++c )
+        {
+            a[c] = XMLoadFloat4A( reinterpret_cast<const XMFLOAT4A*>( in.A[c] ) );
+            b[c] = XMLoadFloat4A( reinterpret_cast<const XMFLOAT4A*>( in.B[c] ) );
+        }
+
+        // Flip b where it is in the other hemisphere so each lane blends along the shorter arc.
+        XMVECTOR dot = XMVectorMultiply( a[0], b[0] );
+        dot          = XMVectorMultiplyAdd( a[1], b[1], dot );
+        dot          = XMVectorMultiplyAdd( a[2], b[2], dot );
+        dot          = XMVectorMultiplyAdd( a[3], b[3], dot );
+
+        XMVECTOR flip = XMVectorAndInt( XMVectorLess( dot, XMVectorZero() ), XMVectorReplicate( -0.0f ) );
+
+        XMVECTOR t = XMLoadFloat4A( reinterpret_cast<const XMFLOAT4A*>( in.T ) );
+        XMVECTOR q[4];
+        XMVECTOR lenSq = XMVectorZero();
+        for ( int c = 0; c < 4; ++c )
+        {
+            XMVECTOR bc = XMVectorXorInt( b[c], flip );
+            q[c]        = XMVectorMultiplyAdd( XMVectorSubtract( bc, a[c] ), t, a[c] );
+            lenSq       = XMVectorMultiplyAdd( q[c], q[c], lenSq );
+        }
+
+        XMVECTOR invLen = XMVectorReciprocal( XMVectorSqrt( lenSq ) );
+        for ( int c = 0; c < 4; ++c )
+            XMStoreFloat4A( reinterpret_cast<XMFLOAT4A*>( out[c] ), XMVectorMultiply( q[c], invLen ) );
+    }
+} // namespace
+
+AnimationClip::AnimationClip( const std::vector<RawTrack>& tracks, float framesPerSecond, const AnimationCompressionSettings& settings ) :
+    mFramesPerSecond( framesPerSecond )
+{
+    mFrameCount = tracks.empty() ? 0 : (std::uint32_t)tracks[0].Frames.size();
+    assert( mFrameCount > 0 && mFrameCount <= MaxFrames );
+
+    std::vector<XMFLOAT3> translations( mFrameCount ), scales( mFrameCount );
+    std::vector<XMFLOAT4> rotations( mFrameCount );
+    for ( const RawTrack& track : tracks )
+    {
+        assert( track.Frames.size() == mFrameCount );
+        for ( std::uint32_t f = 0; f < mFrameCount; ++f )
+        {
+            translations[f] = track.Frames[f].Translation;
+            rotations[f]    = track.Frames[f].Rotation;
+            scales[f]       = track.Frames[f].Scale;
+        }
+
+        AddVec3Channel( translations, settings.TranslationTolerance, mTranslationKeys, mTranslationChannels );
+        AddQuatChannel( rotations, settings.RotationTolerance );
+        AddVec3Channel( scales, settings.ScaleTolerance, mScaleKeys, mScaleChannels );
+    }
+}
+
+void AnimationClip::AddVec3Channel( const std::vector<XMFLOAT3>& values, float tolerance,
+                                    std::vector<Vec3Key>& keys, std::vector<Vec3Channel>& channels )
+{
+    auto load = [&]( size_t f ) { return XMLoadFloat3( &values[f] ); };
+
+    // The quantization range covers every frame, so it is known before reduction and
+    // candidate keys can be measured as they will decode.
+    XMVECTOR vmin = load( 0 );
+    XMVECTOR vmax = vmin;
+    for ( size_t f = 1; f < values.size(); ++f )
+    {
+        vmin = XMVectorMin( vmin, load( f ) );
+        vmax = XMVectorMax( vmax, load( f ) );
+    }
+
+    Vec3Channel channel;
+    XMStoreFloat3( &channel.Min, vmin );
+    XMStoreFloat3( &channel.Extent, XMVectorSubtract( vmax, vmin ) );
+
+    XMVECTOR extent   = XMVectorSubtract( vmax, vmin );
+    XMVECTOR invRange = XMVectorSelect( XMVectorReciprocal( extent ), XMVectorZero(), XMVectorEqual( extent, XMVectorZero() ) );
+
+    auto loadKey = [&]( size_t f ) {
+        std::uint16_t q[3];
+        float         v[3];
+        QuantizeVec3( load( f ), vmin, invRange, q );
+        DequantizeVec3( q, channel.Min, channel.Extent, v );
+        return XMVectorSet( v[0], v[1], v[2], 0.0f );
+    };
+
+    std::vector<std::uint32_t> kept = ReduceKeys( values.size(), tolerance, load, loadKey, XMVectorLerp, Vec3Error );
+
+    channel.FirstKey = (std::uint32_t)keys.size();
+    channel.KeyCount = (std::uint32_t)kept.size();
+
+    for ( std::uint32_t f : kept )
+    {
+        Vec3Key key;
+        key.Frame = (std::uint16_t)f;
+        QuantizeVec3( load( f ), vmin, invRange, key.Value );
+        keys.push_back( key );
+    }
+
+    channels.push_back( channel );
+}
+
+void AnimationClip::AddQuatChannel( const std::vector<XMFLOAT4>& values, float tolerance )
+{
+    auto load = [&]( size_t f ) { return XMQuaternionNormalize( XMLoadFloat4( &values[f] ) ); };
+    auto lerp = []( FXMVECTOR a, FXMVECTOR b, float t ) { return NLerp( a, b, t ); };
+
+    auto loadKey = [&]( size_t f ) {
+        std::int16_t q[3];
+        float        v[4];
+        DequantizeQuat( QuantizeQuat( load( f ), q ), q, v );
+        return XMVectorSet( v[0], v[1], v[2], v[3] );
+    };
+
+    std::vector<std::uint32_t> kept = ReduceKeys( values.size(), tolerance, load, loadKey, lerp, QuatError );
+
+    QuatChannel channel;
+    channel.FirstKey = (std::uint32_t)mRotationKeys.size();
+    channel.KeyCount = (std::uint32_t)kept.size();
+
+    for ( std::uint32_t f : kept )
+    {
+        QuatKey key;
+        int     largest   = QuantizeQuat( load( f ), key.Value );
+        key.FrameAndIndex = (std::uint16_t)( ( f << 2 ) | largest );
+        mRotationKeys.push_back( key );
+    }
+
+    mRotationChannels.push_back( channel );
+}
+
+size_t AnimationClip::GetTrackCount() const
+{
+    return mRotationChannels.size();
+}
+
+size_t AnimationClip::GetKeyCount() const
+{
+    return mTranslationKeys.size() + mRotationKeys.size() + mScaleKeys.size();
+}
+
+float AnimationClip::GetDuration() const
+{
+    return mFrameCount > 1 ? ( mFrameCount - 1 ) / mFramesPerSecond : 0.0f;
+}
+
+void AnimationClip::Sample( float time, size_t firstTrack, size_t trackCount, TransformPose* out ) const
+{
+    assert( firstTrack + trackCount <= GetTrackCount() );
+
+    float frame = std::max<float>( 0.0f, std::min<float>( time * mFramesPerSecond, (float)( mFrameCount - 1 ) ) );
+
+    auto vec3Frame = []( const Vec3Key& k ) { return (std::uint32_t)k.Frame; };
+    auto quatFrame = []( const QuatKey& k ) { return (std::uint32_t)( k.FrameAndIndex >> 2 ); };
+
+    auto decodeVec3 = []( const Vec3Channel& ch, const Vec3Key& k, float( &dst )[3][Lanes], size_t lane ) {
+        float v[3];
+        DequantizeVec3( k.Value, ch.Min, ch.Extent, v );
+        for ( int c = 0; c < 3; ++c )
+            dst[c][lane] = v[c];
+    };
+
+    auto decodeQuat = []( const QuatKey& k, float( &dst )[4][Lanes], size_t lane ) {
+        float v[4];
+        DequantizeQuat( k.FrameAndIndex & 3, k.Value, v );
+        for ( int c = 0; c < 4; ++c )
+            dst[c][lane] = v[c];
+    };
+
+    for ( size_t block = 0; block < trackCount; block += Lanes )
+    {
+        size_t n = std::min<size_t>( Lanes, trackCount - block );
+
+        Vec3Block translation = {}, scale = {};
+        QuatBlock rotation    = {};
+        for ( size_t lane = 0; lane < Lanes; ++lane )
+        {
+            // Unused lanes repeat the last track so the blends see valid data.
+            size_t track = firstTrack + block + std::min<size_t>( lane, n - 1 );
+
+            std::uint32_t i0, i1;
+
+            const Vec3Channel& tc = mTranslationChannels[track];
+            FindSegment( &mTranslationKeys[tc.FirstKey], tc.KeyCount, frame, vec3Frame, i0, i1, translation.T[lane] );
+            decodeVec3( tc, mTranslationKeys[tc.FirstKey + i0], translation.A, lane );
+            decodeVec3( tc, mTranslationKeys[tc.FirstKey + i1], translation.B, lane );
+
+            const QuatChannel& rc = mRotationChannels[track];
+            FindSegment( &mRotationKeys[rc.FirstKey], rc.KeyCount, frame, quatFrame, i0, i1, rotation.T[lane] );
+            decodeQuat( mRotationKeys[rc.FirstKey + i0], rotation.A, lane );
+            decodeQuat( mRotationKeys[rc.FirstKey + i1], rotation.B, lane );
+
+            const Vec3Channel& sc = mScaleChannels[track];
+            FindSegment( &mScaleKeys[sc.FirstKey], sc.KeyCount, frame, vec3Frame, i0, i1, scale.T[lane] );
+            decodeVec3( sc, mScaleKeys[sc.FirstKey + i0], scale.A, lane );
+            decodeVec3( sc, mScaleKeys[sc.FirstKey + i1], scale.B, lane );
+        }
+
+        alignas( 16 ) float t[3][Lanes];
+        alignas( 16 ) float r[4][Lanes];
+        alignas( 16 ) float s[3][Lanes];
+        BlendVec3( translation, t );
+        BlendQuat( rotation, r );
+        BlendVec3( scale, s );
+
+        for ( size_t lane = 0; lane < n; ++lane )
+        {
+            TransformPose& pose = out[block + lane];
+            pose.Translation    = XMFLOAT3( t[0][lane], t[1][lane], t[2][lane] );
+            pose.Rotation       = XMFLOAT4( r[0][lane], r[1][lane], r[2][lane], r[3][lane] );
+            pose.Scale          = XMFLOAT3( s[0][lane], s[1][lane], s[2][lane] );
+        }
+    }
+}
+
+void AnimationClip::Sample( float time, size_t firstTrack, size_t trackCount, Affine3x4* out ) const
+{
+    const size_t  BlockSize = 64;
+    TransformPose poses[BlockSize];
+
+    for ( size_t block = 0; block < trackCount; block += BlockSize )
+    {
+        size_t n = std::min<size_t>( BlockSize, trackCount - block );
+        Sample( time, firstTrack + block, n, poses );
+
+        for ( size_t i = 0; i < n; ++i )
+        {
+            XMMATRIX S = XMMatrixScalingFromVector( XMLoadFloat3( &poses[i].Scale ) );
+            XMMATRIX R = XMMatrixRotationQuaternion( XMLoadFloat4( &poses[i].Rotation ) );
+            XMMATRIX T = XMMatrixTranslationFromVector( XMLoadFloat3( &poses[i].Translation ) );
+            out[block + i].Store( S * R * T );
+        }
+    }
+}
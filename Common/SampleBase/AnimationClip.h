@@ -0,0 +1,114 @@
+//***************************************************************************************
+// AnimationClip.h
+//
+// Compressed keyframe animation for many transforms (e.g. the joints of a skeleton or
+// the nodes of a TransformHierarchy).
+//
+// A clip is built from tracks sampled at a fixed rate.  Building removes keys that
+// linear interpolation reproduces within a tolerance and quantizes the rest:
+//   -translation and scale: 16 bits per component within the range of the track,
+//   -rotation: "smallest three" quaternion encoding with 15 bits per component.
+// The tolerance is checked against the quantized keys, so it bounds the error of the
+// stored clip at every source frame.  It cannot be met below half a quantization step,
+// i.e. 1/131070 of a track's range of translation or scale.
+// Every key, including its frame number, fits in 8 bytes, and the keys of all tracks
+// are stored in one contiguous array per channel.
+//
+// Sampling decodes the two keys around the sample time for each track, then blends
+// 4 tracks at a time with SIMD: lerp for translation and scale, and nlerp (normalized
+// lerp along the shorter arc) for rotation.  Between keys that are close together, as
+// they are after reduction, nlerp is visually indistinguishable from slerp.
+//***************************************************************************************
+
+#pragma once
+
+#include "Affine3x4.h"
+#include <cstdint>
+#include <vector>
+
+// Local transform of one track.
+struct TransformPose
+{
+    DirectX::XMFLOAT3 Translation = { 0.0f, 0.0f, 0.0f };
+    DirectX::XMFLOAT4 Rotation    = { 0.0f, 0.0f, 0.0f, 1.0f };
+    DirectX::XMFLOAT3 Scale       = { 1.0f, 1.0f, 1.0f };
+};
+
+// Maximum error allowed when removing keys.
+struct AnimationCompressionSettings
+{
+    float TranslationTolerance = 0.001f; // in world units
+    float RotationTolerance    = 0.001f; // in radians
+    float ScaleTolerance       = 0.001f;
+};
+
+class AnimationClip
+{
+public:
+    // One pose per frame.  All tracks of a clip have the same number of frames.
+    struct RawTrack
+    {
+        std::vector<TransformPose> Frames;
+    };
+
+    AnimationClip() = default;
+    AnimationClip( const std::vector<RawTrack>& tracks, float framesPerSecond,
+                   const AnimationCompressionSettings& settings = AnimationCompressionSettings() );
+
+    size_t GetTrackCount() const;
+    size_t GetKeyCount() const;
+    float  GetDuration() const;
+
+    // Samples trackCount tracks starting at firstTrack.  time is clamped to the clip, so
+    // wrap it first for looping playback.  Disjoint track ranges may be sampled from
+    // different threads at the same time.
+    void Sample( float time, size_t firstTrack, size_t trackCount, TransformPose* out ) const;
+
+    // As above, but composes each pose into a scale * rotation * translation matrix,
+    // ready for TransformHierarchy::SetLocal or for upload.
+    void Sample( float time, size_t firstTrack, size_t trackCount, Affine3x4* out ) const;
+
+private:
+    struct Vec3Key
+    {
+        std::uint16_t Frame;
+        std::uint16_t Value[3];
+    };
+
+    struct QuatKey
+    {
+        std::uint16_t FrameAndIndex; // frame << 2 | index of the dropped component
+        std::int16_t  Value[3];
+    };
+
+    // Quantization range and key range of a translation or scale channel.
+    struct Vec3Channel
+    {
+        DirectX::XMFLOAT3 Min;
+        DirectX::XMFLOAT3 Extent;
+        std::uint32_t     FirstKey;
+        std::uint32_t     KeyCount;
+    };
+
+    struct QuatChannel
+    {
+        std::uint32_t FirstKey;
+        std::uint32_t KeyCount;
+    };
+
+    void AddVec3Channel( const std::vector<DirectX::XMFLOAT3>& values, float tolerance,
+                         std::vector<Vec3Key>& keys, std::vector<Vec3Channel>& channels );
+    void AddQuatChannel( const std::vector<DirectX::XMFLOAT4>& values, float tolerance );
+
+private:
+    float         mFramesPerSecond = 30.0f;
+    std::uint32_t mFrameCount      = 0;
+
+    std::vector<Vec3Channel> mTranslationChannels;
+    std::vector<QuatChannel> mRotationChannels;
+    std::vector<Vec3Channel> mScaleChannels;
+
+    std::vector<Vec3Key> mTranslationKeys;
+    std::vector<QuatKey> mRotationKeys;
+    std::vector<Vec3Key> mScaleKeys;
+};
@@ -0,0 +1,331 @@
+//***************************************************************************************
+// BatchMath.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "BatchMath.h"
+#include "CpuFeatures.h"
+#include "MathHelper.h"
+#include <cmath>
+#include <immintrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+    // Upper 3x4 part of a row-vector transform: out = in * M + T.
+    struct AffineCoeffs
+    {
+        float M[3][3];
+        float T[3];
+    };
+
+    AffineCoeffs MakeCoeffs( CXMMATRIX m, bool translate )
+    {
+        XMFLOAT4X4 f;
+        XMStoreFloat4x4( &f, m );
+
+        AffineCoeffs c;
+        for ( int i = 0; i < 3; ++i )
+        {
+            for ( int j = 0; j < 3; ++j )
+                c.M[i][j] = f.m[i][j];
+
+            c.T[i] = translate ? f.m[3][i] : 0.0f;
+        }
+        return c;
+    }
+
+    //
+    // Scalar kernels.  Used for the tail of every batch.
+    //
+
+    void TransformScalar( const Float3SoA& in, const Float3SoA& out, size_t begin, size_t end, const AffineCoeffs& c )
+    {
+        for ( size_t i = begin; i < end; ++i )
+        {
+            float x = in.X[i];
+            float y = in.Y[i];
+            float z = in.Z[i];
+
+            out.X[i] = x * c.M[0][0] + y * c.M[1][0] + z * c.M[2][0] + c.T[0];
+            out.Y[i] = x * c.M[0][1] + y * c.M[1][1] + z * c.M[2][1] + c.T[1];
+            out.Z[i] = x * c.M[0][2] + y * c.M[1][2] + z * c.M[2][2] + c.T[2];
+        }
+    }
+
+    void NormalizeScalar( const Float3SoA& v, size_t begin, size_t end )
+    {
+        for ( size_t i = begin; i < end; ++i )
+        {
+            float lenSq = v.X[i] * v.X[i] + v.Y[i] * v.Y[i] + v.Z[i] * v.Z[i];
+            if ( lenSq > 0.0f )
+            {
+                float invLen = 1.0f / sqrtf( lenSq );
+                v.X[i] *= invLen;
+                v.Y[i] *= invLen;
+                v.Z[i] *= invLen;
+            }
+        }
+    }
+
+    //
+    // SSE2 kernels, 4 vectors per iteration.  Return the number of vectors processed.
+    //
+
+    size_t TransformSSE( const Float3SoA& in, const Float3SoA& out, size_t count, const AffineCoeffs& c )
+    {
+        const __m128 m00 = _mm_set1_ps( c.M[0][0] ), m01 = _mm_set1_ps( c.M[0][1] ), m02 = _mm_set1_ps( c.M[0][2] );
+        const __m128 m10 = _mm_set1_ps( c.M[1][0] ), m11 = _mm_set1_ps( c.M[1][1] ), m12 = _mm_set1_ps( c.M[1][2] );
+        const __m128 m20 = _mm_set1_ps( c.M[2][0] ), m21 = _mm_set1_ps( c.M[2][1] ), m22 = _mm_set1_ps( c.M[2][2] );
+        const __m128 t0 = _mm_set1_ps( c.T[0] ), t1 = _mm_set1_ps( c.T[1] ), t2 = _mm_set1_ps( c.T[2] );
+
+        size_t n = count & ~size_t( 3 );
+        for ( size_t i = 0; i < n; i += 4 )
+        {
+            __m128 x = _mm_loadu_ps( in.X + i );
+            __m128 y = _mm_loadu_ps( in.Y + i );
+            __m128 z = _mm_loadu_ps( in.Z + i );
+
+            __m128 ox = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, m00 ), _mm_mul_ps( y, m10 ) ), _mm_add_ps( _mm_mul_ps( z, m20 ), t0 ) );
+            __m128 oy = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, m01 ), _mm_mul_ps( y, m11 ) ), _mm_add_ps( _mm_mul_ps( z, m21 ), t1 ) );
+            __m128 oz = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, m02 ), _mm_mul_ps( y, m12 ) ), _mm_add_ps( _mm_mul_ps( z, m22 ), t2 ) );
+
+            _mm_storeu_ps( out.X + i, ox );
+            _mm_storeu_ps( out.Y + i, oy );
+            _mm_storeu_ps( out.Z + i, oz );
+        }
+        return n;
+    }
+
+    size_t NormalizeSSE( const Float3SoA& v, size_t count )
+    {
+        const __m128 half      = _mm_set1_ps( 0.5f );
+        const __m128 threeHalf = _mm_set1_ps( 1.5f );
+        const __m128 one       = _mm_set1_ps( 1.0f );
+        const __m128 zero      = _mm_setzero_ps();
+
+        size_t n = count & ~size_t( 3 );
+        for ( size_t i = 0; i < n; i += 4 )
+        {
+            __m128 x = _mm_loadu_ps( v.X + i );
+            __m128 y = _mm_loadu_ps( v.Y + i );
+            __m128 z = _mm_loadu_ps( v.Z + i );
+
+            __m128 lenSq = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) );
+
+            // rsqrt estimate refined with one Newton-Raphson step (~23 bits).
+            __m128 r = _mm_rsqrt_ps( lenSq );
+            r        = _mm_mul_ps( r, _mm_sub_ps( threeHalf, _mm_mul_ps( _mm_mul_ps( half, lenSq ), _mm_mul_ps( r, r ) ) ) );
+
+            // Leave zero length vectors alone.
+            __m128 valid = _mm_cmpgt_ps( lenSq, zero );
+            r            = _mm_or_ps( _mm_and_ps( valid, r ), _mm_andnot_ps( valid, one ) );
+
+            _mm_storeu_ps( v.X + i, _mm_mul_ps( x, r ) );
+            _mm_storeu_ps( v.Y + i, _mm_mul_ps( y, r ) );
+            _mm_storeu_ps( v.Z + i, _mm_mul_ps( z, r ) );
+        }
+        return n;
+    }
+
+    //
+    // AVX2/FMA kernels, 8 vectors per iteration.
+    //
+
+    size_t TransformAVX2( const Float3SoA& in, const Float3SoA& out, size_t count, const AffineCoeffs& c )
+    {
+        const __m256 m00 = _mm256_set1_ps( c.M[0][0] ), m01 = _mm256_set1_ps( c.M[0][1] ), m02 = _mm256_set1_ps( c.M[0][2] );
+        const __m256 m10 = _mm256_set1_ps( c.M[1][0] ), m11 = _mm256_set1_ps( c.M[1][1] ), m12 = _mm256_set1_ps( c.M[1][2] );
+        const __m256 m20 = _mm256_set1_ps( c.M[2][0] ), m21 = _mm256_set1_ps( c.M[2][1] ), m22 = _mm256_set1_ps( c.M[2][2] );
+        const __m256 t0 = _mm256_set1_ps( c.T[0] ), t1 = _mm256_set1_ps( c.T[1] ), t2 = _mm256_set1_ps( c.T[2] );
+
+        size_t n = count & ~size_t( 7 );
+        for ( size_t i = 0; i < n; i += 8 )
+        {
+            __m256 x = _mm256_loadu_ps( in.X + i );
+            __m256 y = _mm256_loadu_ps( in.Y + i );
+            __m256 z = _mm256_loadu_ps( in.Z + i );
+
+            __m256 ox = _mm256_fmadd_ps( x, m00, _mm256_fmadd_ps( y, m10, _mm256_fmadd_ps( z, m20, t0 ) ) );
+            __m256 oy = _mm256_fmadd_ps( x, m01, _mm256_fmadd_ps( y, m11, _mm256_fmadd_ps( z, m21, t1 ) ) );
+            __m256 oz = _mm256_fmadd_ps( x, m02, _mm256_fmadd_ps( y, m12, _mm256_fmadd_ps( z, m22, t2 ) ) );
+
+            _mm256_storeu_ps( out.X + i, ox );
+            _mm256_storeu_ps( out.Y + i, oy );
+            _mm256_storeu_ps( out.Z + i, oz );
+        }
+        return n;
+    }
+
+    size_t NormalizeAVX2( const Float3SoA& v, size_t count )
+    {
+        const __m256 half      = _mm256_set1_ps( 0.5f );
+        const __m256 threeHalf = _mm256_set1_ps( 1.5f );
+        const __m256 one       = _mm256_set1_ps( 1.0f );
+        const __m256 zero      = _mm256_setzero_ps();
+
+        size_t n = count & ~size_t( 7 );
+        for ( size_t i = 0; i < n; i += 8 )
+        {
+            __m256 x = _mm256_loadu_ps( v.X + i );
+            __m256 y = _mm256_loadu_ps( v.Y + i );
+            __m256 z = _mm256_loadu_ps( v.Z + i );
+
+            __m256 lenSq = _mm256_fmadd_ps( x, x, _mm256_fmadd_ps( y, y, _mm256_mul_ps( z, z ) ) );
+
+            __m256 r = _mm256_rsqrt_ps( lenSq );
+            r        = _mm256_mul_ps( r, _mm256_fnmadd_ps( _mm256_mul_ps( half, lenSq ), _mm256_mul_ps( r, r ), threeHalf ) );
+            r        = _mm256_blendv_ps( one, r, _mm256_cmp_ps( lenSq, zero, _CMP_GT_OQ ) );
+
+            _mm256_storeu_ps( v.X + i, _mm256_mul_ps( x, r ) );
+            _mm256_storeu_ps( v.Y + i, _mm256_mul_ps( y, r ) );
+            _mm256_storeu_ps( v.Z + i, _mm256_mul_ps( z, r ) );
+        }
+        return n;
+    }
+
+    struct KernelTable
+    {
+        size_t ( *Transform )( const Float3SoA&, const Float3SoA&, size_t, const AffineCoeffs& );
+        size_t ( *Normalize )( const Float3SoA&, size_t );
+    };
+
+    const KernelTable& GetKernels()
+    {
+        // SSE2 is part of the x64 baseline, so it is the fallback SIMD path.
+        static const KernelTable kernels = CpuFeatures::HasAVX2() ? KernelTable { TransformAVX2, NormalizeAVX2 } :
+                                                                    KernelTable { TransformSSE, NormalizeSSE };
+        return kernels;
+    }
+
+    void Transform( const Float3SoA& in, const Float3SoA& out, size_t count, const AffineCoeffs& c )
+    {
+        size_t done = GetKernels().Transform( in, out, count, c );
+        TransformScalar( in, out, done, count, c );
+    }
+} // namespace
+
+void BatchMath::TransformPoints( const Float3SoA& in, const Float3SoA& out, size_t count, CXMMATRIX M )
+{
+    Transform( in, out, count, MakeCoeffs( M, true ) );
+}
+
+void BatchMath::TransformVectors( const Float3SoA& in, const Float3SoA& out, size_t count, CXMMATRIX M )
+{
+    Transform( in, out, count, MakeCoeffs( M, false ) );
+}
+
+void BatchMath::TransformNormals( const Float3SoA& in, const Float3SoA& out, size_t count, CXMMATRIX M )
+{
+    Transform( in, out, count, MakeCoeffs( MathHelper::InverseTranspose( M ), false ) );
+    Normalize( out, count );
+}
+
+void BatchMath::Normalize( const Float3SoA& v, size_t count )
+{
+    size_t done = GetKernels().Normalize( v, count );
+    NormalizeScalar( v, done, count );
+}
+
+void BatchMath::Deinterleave( const XMFLOAT3* in, size_t strideInBytes, size_t count, const Float3SoA& out )
+{
+    const BYTE* src = reinterpret_cast<const BYTE*>( in );
+    for ( size_t i = 0; i < count; ++i, src += strideInBytes )
+    {
+        const XMFLOAT3* v = reinterpret_cast<const XMFLOAT3*>( src );
+        out.X[i]          = v->x;
+        out.Y[i]          = v->y;
+        out.Z[i]          = v->z;
+    }
+}
+
+void BatchMath::Interleave( const Float3SoA& in, size_t count, XMFLOAT3* out, size_t strideInBytes )
+{
+    BYTE* dst = reinterpret_cast<BYTE*>( out );
+    for ( size_t i = 0; i < count; ++i, dst += strideInBytes )
+    {
+        XMFLOAT3* v = reinterpret_cast<XMFLOAT3*>( dst );
+        v->x        = in.X[i];
+        v->y        = in.Y[i];
+        v->z        = in.Z[i];
+    }
+}
+
+void BatchMath::InverseTranspose( const XMFLOAT4X4* in, size_t inStrideInBytes, size_t count,
+                                  XMFLOAT3X4* out, size_t outStrideInBytes )
+{
+    // Relative tolerance for treating the rows of the 3x3 part as orthogonal and of equal length.
+    const float Epsilon = 1e-5f;
+
+    const BYTE* src = reinterpret_cast<const BYTE*>( in );
+    BYTE*       dst = reinterpret_cast<BYTE*>( out );
+    for ( size_t i = 0; i < count; ++i, src += inStrideInBytes, dst += outStrideInBytes )
+    {
+        const XMFLOAT4X4& m = *reinterpret_cast<const XMFLOAT4X4*>( src );
+        XMFLOAT3X4&       n = *reinterpret_cast<XMFLOAT3X4*>( dst );
+
+        bool affine = m._14 == 0.0f && m._24 == 0.0f && m._34 == 0.0f && m._44 == 1.0f;
+
+        XMVECTOR r0 = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( m.m[0] ) );
+        XMVECTOR r1 = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( m.m[1] ) );
+        XMVECTOR r2 = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( m.m[2] ) );
+
+        XMVECTOR n0, n1, n2;
+        bool     done = false;
+        if ( affine )
+        {
+            XMVECTOR lenSq = XMVectorSet( XMVectorGetX( XMVector3Dot( r0, r0 ) ),
+                                          XMVectorGetX( XMVector3Dot( r1, r1 ) ),
+                                          XMVectorGetX( XMVector3Dot( r2, r2 ) ), 0.0f );
+            XMVECTOR dots  = XMVectorSet( XMVectorGetX( XMVector3Dot( r0, r1 ) ),
+                                          XMVectorGetX( XMVector3Dot( r1, r2 ) ),
+                                          XMVectorGetX( XMVector3Dot( r2, r0 ) ), 0.0f );
+
+            XMVECTOR s2  = XMVectorSplatX( lenSq );
+            XMVECTOR tol = XMVectorScale( s2, Epsilon );
+
+            if ( XMVectorGetX( s2 ) > 0.0f &&
+                 XMVector3LessOrEqual( XMVectorAbs( XMVectorSubtract( lenSq, s2 ) ), tol ) &&
+                 XMVector3LessOrEqual( XMVectorAbs( dots ), tol ) )
+            {
+                // Rotation * uniform scale s: the inverse-transpose is M / s^2.
+                XMVECTOR invS2 = XMVectorReciprocal( s2 );
+                n0             = XMVectorMultiply( r0, invS2 );
+                n1             = XMVectorMultiply( r1, invS2 );
+                n2             = XMVectorMultiply( r2, invS2 );
+                done           = true;
+            }
+            else
+            {
+                // inverse(A)^T = cofactor(A) / det(A), whose rows are cross products of the rows of A.
+                XMVECTOR c0  = XMVector3Cross( r1, r2 );
+                XMVECTOR det = XMVector3Dot( r0, c0 );
+                if ( XMVectorGetX( det ) != 0.0f )
+                {
+                    XMVECTOR invDet = XMVectorReciprocal( det );
+                    n0              = XMVectorMultiply( c0, invDet );
+                    n1              = XMVectorMultiply( XMVector3Cross( r2, r0 ), invDet );
+                    n2              = XMVectorMultiply( XMVector3Cross( r0, r1 ), invDet );
+                    done            = true;
+                }
+            }
+        }
+
+        XMMATRIX N;
+        if ( done )
+        {
+            N = XMMatrixTranspose( XMMATRIX( XMVectorSetW( n0, 0.0f ), XMVectorSetW( n1, 0.0f ),
+                                             XMVectorSetW( n2, 0.0f ), XMVectorZero() ) );
+        }
+        else
+        {
+            N = XMMatrixTranspose( MathHelper::InverseTranspose( XMLoadFloat4x4( &m ) ) );
+        }
+
+        XMStoreFloat4( reinterpret_cast<XMFLOAT4*>( n.m[0] ), N.r[0] );
+        XMStoreFloat4( reinterpret_cast<XMFLOAT4*>( n.m[1] ), N.r[1] );
+        XMStoreFloat4( reinterpret_cast<XMFLOAT4*>( n.m[2] ), N.r[2] );
+    }
+}
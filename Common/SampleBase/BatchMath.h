@@ -0,0 +1,58 @@
+//***************************************************************************************
+// BatchMath.h
+//
+// Transform kernels that process whole arrays of vectors at a time.
+//
+// Vectors are stored structure-of-arrays (one float array per component) so that
+// 4 (SSE2) or 8 (AVX2) vectors are processed per instruction.  The AVX2 path is
+// selected once at runtime when the CPU supports it, the SSE2 path otherwise; a scalar
+// loop handles the remainder.
+//
+// Input and output streams may alias (in-place transforms are allowed).
+//***************************************************************************************
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+
+// Structure-of-arrays view of count 3D vectors.
+struct Float3SoA
+{
+    float* X = nullptr;
+    float* Y = nullptr;
+    float* Z = nullptr;
+};
+
+class BatchMath
+{
+public:
+    // out[i] = (in[i], 1) * M, dropping w.  Use for positions.
+    static void TransformPoints( const Float3SoA& in, const Float3SoA& out, size_t count, DirectX::CXMMATRIX M );
+
+    // out[i] = (in[i], 0) * M.  Use for directions and tangents.
+    static void TransformVectors( const Float3SoA& in, const Float3SoA& out, size_t count, DirectX::CXMMATRIX M );
+
+    // out[i] = normalize( (in[i], 0) * InverseTranspose(M) ).  Use for normals.
+    static void TransformNormals( const Float3SoA& in, const Float3SoA& out, size_t count, DirectX::CXMMATRIX M );
+
+    // Normalizes count vectors in place.  Zero length vectors are left unchanged.
+    static void Normalize( const Float3SoA& v, size_t count );
+
+    // Converts between array-of-structures data (e.g. the Position member of a
+    // vertex array, with the vertex size as stride) and structure-of-arrays streams.
+    static void Deinterleave( const DirectX::XMFLOAT3* in, size_t strideInBytes, size_t count, const Float3SoA& out );
+    static void Interleave( const Float3SoA& in, size_t count, DirectX::XMFLOAT3* out, size_t strideInBytes );
+
+    ///<summary>
+    /// Computes MathHelper::InverseTranspose for count world matrices, e.g. the World member
+    /// of an array of object constants (with the struct size as stride).  Each result is
+    /// written transposed as a 3x4, which is what an HLSL float4x3 holds under the default
+    /// column-major packing, so out can point straight into mapped constant buffer memory.
+    ///
+    /// Rotation + uniform scale matrices take the shortcut M/s^2, other affine matrices the
+    /// 3x3 cofactor path.  Only projective or singular matrices pay for a full 4x4 inverse.
+    ///</summary>
+    static void InverseTranspose( const DirectX::XMFLOAT4X4* in, size_t inStrideInBytes, size_t count,
+                                  DirectX::XMFLOAT3X4* out, size_t outStrideInBytes );
+};
@@ -4,6 +4,7 @@
 
 #include "stdafx.h"
 #include "Camera.h"
+#include "LowDiscrepancy.h"
 
 using namespace DirectX;
 
@@ -165,6 +166,10 @@ XMMATRIX Camera::GetProj() const
     return XMLoadFloat4x4( &mProj );
 }
 
+XMMATRIX Camera::GetViewProj() const
+{
+    return XMMatrixMultiply( GetView(), GetProj() );
+}
 
 XMFLOAT4X4 Camera::GetView4x4f() const
 {
@@ -271,4 +276,69 @@ void Camera::UpdateViewMatrix()
 
         mViewDirty = false;
     }
+
+    UpdateFrameConstants();
+}
+
+void Camera::SetJitter( int sampleCount, float viewportWidth, float viewportHeight )
+{
+    assert( sampleCount >= 0 );
+    assert( viewportWidth > 0.0f && viewportHeight > 0.0f );
+
+    mJitterSampleCount = sampleCount;
+    mJitterIndex       = 0;
+    mViewportWidth     = viewportWidth;
+    mViewportHeight    = viewportHeight;
+}
+
+void Camera::ResetHistory()
+{
+    mHasHistory = false;
+}
+
+const CameraFrameConstants& Camera::GetFrameConstants() const
+{
+    return mFrame;
+}
+
+void Camera::UpdateFrameConstants()
+{
+    XMFLOAT2 jitter( 0.0f, 0.0f );
+    if ( mJitterSampleCount > 0 )
+    {
+        // Skip index 0 of the Halton sequence, which is the pixel corner (0, 0).
+        mJitterIndex = mJitterIndex % mJitterSampleCount + 1;
+        jitter.x     = LowDiscrepancy::Halton( 0, mJitterIndex ) - 0.5f;
+        jitter.y     = LowDiscrepancy::Halton( 1, mJitterIndex ) - 0.5f;
+    }
+
+    // Shifting the projection's z row offsets clip x and y by jitter * w, i.e. by a
+    // constant in NDC.  NDC y points up while pixel rows go down.
+    XMFLOAT4X4 jitteredProj = mProj;
+    jitteredProj( 2, 0 ) += 2.0f * jitter.x / mViewportWidth;
+    jitteredProj( 2, 1 ) -= 2.0f * jitter.y / mViewportHeight;
+
+    XMMATRIX view     = XMLoadFloat4x4( &mView );
+    XMMATRIX proj     = XMLoadFloat4x4( &jitteredProj );
+    XMMATRIX viewProj = XMMatrixMultiply( view, proj );
+
+    mFrame.PrevViewProj = mFrame.UnjitteredViewProj;
+    mFrame.PrevJitter   = mFrame.Jitter;
+
+    mFrame.View     = mView;
+    mFrame.Proj     = jitteredProj;
+    mFrame.EyePosW  = mPosition;
+    mFrame.Jitter   = jitter;
+    XMStoreFloat4x4( &mFrame.ViewProj, viewProj );
+    XMStoreFloat4x4( &mFrame.UnjitteredViewProj, XMMatrixMultiply( view, XMLoadFloat4x4( &mProj ) ) );
+    XMStoreFloat4x4( &mFrame.InvView, XMMatrixInverse( nullptr, view ) );
+    XMStoreFloat4x4( &mFrame.InvProj, XMMatrixInverse( nullptr, proj ) );
+    XMStoreFloat4x4( &mFrame.InvViewProj, XMMatrixInverse( nullptr, viewProj ) );
+
+    if ( !mHasHistory )
+    {
+        mFrame.PrevViewProj = mFrame.UnjitteredViewProj;
+        mFrame.PrevJitter   = jitter;
+        mHasHistory         = true;
+    }
 }
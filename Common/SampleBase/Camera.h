@@ -13,6 +13,29 @@
 
 #include "d3dUtil.h"
 
+// Per-frame camera matrices, laid out to be copied straight into a constant buffer.
+// Proj, ViewProj and their inverses include the TAA jitter; UnjitteredViewProj and
+// PrevViewProj do not, so the difference of the two gives motion vectors that are
+// free of jitter.
+struct CameraFrameConstants
+{
+    DirectX::XMFLOAT4X4 View               = MathHelper::Identity4x4();
+    DirectX::XMFLOAT4X4 InvView            = MathHelper::Identity4x4();
+    DirectX::XMFLOAT4X4 Proj               = MathHelper::Identity4x4();
+    DirectX::XMFLOAT4X4 InvProj            = MathHelper::Identity4x4();
+    DirectX::XMFLOAT4X4 ViewProj           = MathHelper::Identity4x4();
+    DirectX::XMFLOAT4X4 InvViewProj        = MathHelper::Identity4x4();
+    DirectX::XMFLOAT4X4 UnjitteredViewProj = MathHelper::Identity4x4();
+    DirectX::XMFLOAT4X4 PrevViewProj       = MathHelper::Identity4x4();
+
+    DirectX::XMFLOAT3 EyePosW = {0.0f, 0.0f, 0.0f};
+    float             Pad0    = 0.0f;
+
+    // Sub-pixel offsets of this and the previous frame, in pixels (x right, y down).
+    DirectX::XMFLOAT2 Jitter     = {0.0f, 0.0f};
+    DirectX::XMFLOAT2 PrevJitter = {0.0f, 0.0f};
+};
+
 class Camera
 {
 public:
@@ -56,6 +79,7 @@ public:
     // Get View/Proj matrices.
     DirectX::XMMATRIX GetView() const;
     DirectX::XMMATRIX GetProj() const;
+    DirectX::XMMATRIX GetViewProj() const;
 
     DirectX::XMFLOAT4X4 GetView4x4f() const;
     DirectX::XMFLOAT4X4 GetProj4x4f() const;
@@ -68,9 +92,26 @@ public:
     void Pitch(float angle);
     void RotateY(float angle);
 
+    // Enables TAA jitter: the projection is offset by a Halton (2, 3) sequence of
+    // sampleCount sub-pixel positions for a viewport of the given size.  A sampleCount
+    // of 0 disables it.
+    void SetJitter(int sampleCount, float viewportWidth, float viewportHeight);
+
+    // Drops the previous frame, e.g. after a camera cut, so that the next frame's
+    // PrevViewProj equals its own and no motion is reported.
+    void ResetHistory();
+
     // After modifying camera position/orientation, call to rebuild the view matrix.
+    // Call once per frame: it also advances the jitter sequence and refreshes the
+    // frame constants, moving the current frame's matrices into the previous ones.
     void UpdateViewMatrix();
 
+    // Matrices of the frame set up by the last UpdateViewMatrix.
+    const CameraFrameConstants& GetFrameConstants() const;
+
+private:
+    void UpdateFrameConstants();
+
 private:
     // Camera coordinate system with coordinates relative to world space.
     DirectX::XMFLOAT3 mPosition = {0.0f, 0.0f, 0.0f};
@@ -91,6 +132,15 @@ private:
     // Cache View/Proj matrices.
     DirectX::XMFLOAT4X4 mView = MathHelper::Identity4x4();
     DirectX::XMFLOAT4X4 mProj = MathHelper::Identity4x4();
+
+    // TAA jitter sequence.
+    int   mJitterSampleCount = 0;
+    int   mJitterIndex       = 0;
+    float mViewportWidth     = 1.0f;
+    float mViewportHeight    = 1.0f;
+
+    bool                 mHasHistory = false;
+    CameraFrameConstants mFrame;
 };
 
 #endif // CAMERA_H
\ No newline at end of file
@@ -0,0 +1,184 @@
+//***************************************************************************************
+// CascadedShadows.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "CascadedShadows.h"
+#include "Camera.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+const int CascadedShadows::MaxCascades;
+
+namespace
+{
+    // Bounding sphere radii are rounded up to this step, so that float noise in the
+    // camera parameters cannot change the texel size from one frame to the next.
+    const float RadiusQuantum = 1.0f / 16.0f;
+
+    // Bounding sphere of the slice [n, f] of a symmetric view frustum whose half
+    // diagonal grows by k per unit of depth.  Returns the radius and the distance of the
+    // center along the view direction.
+    float SliceBoundingSphere( float n, float f, float k, float& centerDistance )
+    {
+        float k2 = k * k;
+        if ( k2 >= ( f - n ) / ( f + n ) )
+        {
+            // The far cap's circle bounds the whole slice.
+            centerDistance = f;
+            return f * k;
+        }
+
+        centerDistance = 0.5f * ( f + n ) * ( 1.0f + k2 );
+        return 0.5f * std::sqrt( ( f - n ) * ( f - n ) + 2.0f * ( f * f + n * n ) * k2 + ( f + n ) * ( f + n ) * k2 * k2 );
+    }
+} // namespace
+
+void CascadedShadows::Update( const Camera& camera, const Light& light, const ShadowCascadeSettings& settings )
+{
+    assert( settings.CascadeCount >= 1 && settings.CascadeCount <= MaxCascades );
+    assert( settings.ShadowMapSize > 2 );
+
+    mCascadeCount  = settings.CascadeCount;
+    mShadowMapSize = settings.ShadowMapSize;
+
+    // Light space looks along the light direction from the origin; only the rotation
+    // matters, the cascades position themselves inside it.
+    XMVECTOR direction = XMVector3Normalize( XMLoadFloat3( &light.Direction ) );
+    XMVECTOR up        = std::fabs( XMVectorGetY( direction ) ) > 0.99f ? XMVectorSet( 0.0f, 0.0f, 1.0f, 0.0f ) : XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f );
+    XMMATRIX lightView = XMMatrixLookToLH( XMVectorZero(), direction, up );
+    XMStoreFloat4x4( &mLightView, lightView );
+
+    float nearZ = camera.GetNearZ();
+    float farZ  = settings.MaxDistance > 0.0f ? std::min<float>( settings.MaxDistance, camera.GetFarZ() ) : camera.GetFarZ();
+
+    float tanHalfFovY = std::tan( 0.5f * camera.GetFovY() );
+    float k           = tanHalfFovY * std::sqrt( 1.0f + camera.GetAspect() * camera.GetAspect() );
+
+    float splitNear = nearZ;
+    for ( int i = 0; i < mCascadeCount; ++i )
+    {
+        // Practical split scheme.
+        float t           = float( i + 1 ) / mCascadeCount;
+        float logSplit    = nearZ * std::pow( farZ / nearZ, t );
+        float linearSplit = nearZ + ( farZ - nearZ ) * t;
+        float splitFar    = settings.SplitLambda * logSplit + ( 1.0f - settings.SplitLambda ) * linearSplit;
+
+        float centerDistance;
+        float radius = SliceBoundingSphere( splitNear, splitFar, k, centerDistance );
+        radius       = std::ceil( radius / RadiusQuantum ) * RadiusQuantum;
+
+        XMVECTOR centerWorld = XMVectorMultiplyAdd( camera.GetLook(), XMVectorReplicate( centerDistance ), camera.GetPosition() );
+        XMFLOAT3 center;
+        XMStoreFloat3( &center, XMVector3TransformCoord( centerWorld, lightView ) );
+
+        // Leave a one texel margin for the snapping below: with halfSize = r * size /
+        // ( size - 2 ), a texel is 2r / ( size - 2 ) and halfSize - r is exactly one texel.
+        float halfSize  = radius * mShadowMapSize / ( mShadowMapSize - 2 );
+        float texelSize = 2.0f * halfSize / mShadowMapSize;
+
+        mCenter[i]   = XMFLOAT2( std::floor( center.x / texelSize ) * texelSize, std::floor( center.y / texelSize ) * texelSize );
+        mHalfSize[i] = halfSize;
+        mNearZ[i]    = center.z - radius - settings.CasterDistance;
+        mFarZ[i]     = center.z + radius;
+
+        ShadowCascade& cascade = mCascades[i];
+        cascade.SplitNear      = splitNear;
+        cascade.SplitFar       = splitFar;
+        cascade.Left           = 0;
+        cascade.Top            = 0;
+        cascade.Right          = mShadowMapSize;
+        cascade.Bottom         = mShadowMapSize;
+        cascade.Casters.clear();
+        UpdateProjection( i );
+
+        splitNear = splitFar;
+    }
+}
+
+void CascadedShadows::CullCasters( const BoxBoundsSoA& casters )
+{
+    const XMFLOAT4X4& r = mLightView;
+
+    float    nearestZ[MaxCascades];
+    XMFLOAT2 rectMin[MaxCascades];
+    XMFLOAT2 rectMax[MaxCascades];
+    for ( int c = 0; c < mCascadeCount; ++c )
+    {
+        nearestZ[c] = FLT_MAX;
+        rectMin[c]  = XMFLOAT2( FLT_MAX, FLT_MAX );
+        rectMax[c]  = XMFLOAT2( -FLT_MAX, -FLT_MAX );
+        mCascades[c].Casters.clear();
+    }
+
+    for ( size_t i = 0; i < casters.GetCount(); ++i )
+    {
+        float cx = casters.CenterX()[i], cy = casters.CenterY()[i], cz = casters.CenterZ()[i];
+        float ex = casters.ExtentX()[i], ey = casters.ExtentY()[i], ez = casters.ExtentZ()[i];
+
+        // Light space box around the world space box.
+        float lx  = cx * r._11 + cy * r._21 + cz * r._31;
+        float ly  = cx * r._12 + cy * r._22 + cz * r._32;
+        float lz  = cx * r._13 + cy * r._23 + cz * r._33;
+        float lex = ex * std::fabs( r._11 ) + ey * std::fabs( r._21 ) + ez * std::fabs( r._31 );
+        float ley = ex * std::fabs( r._12 ) + ey * std::fabs( r._22 ) + ez * std::fabs( r._32 );
+        float lez = ex * std::fabs( r._13 ) + ey * std::fabs( r._23 ) + ez * std::fabs( r._33 );
+
+        for ( int c = 0; c < mCascadeCount; ++c )
+        {
+            // Casters may lie anywhere toward the light, but must overlap the cascade's
+            // square and start before its far plane.
+            if ( std::fabs( lx - mCenter[c].x ) > lex + mHalfSize[c] || std::fabs( ly - mCenter[c].y ) > ley + mHalfSize[c] ||
+                 lz - lez > mFarZ[c] )
+            {
+                continue;
+            }
+
+            mCascades[c].Casters.push_back( static_cast<std::uint32_t>( i ) );
+            nearestZ[c]  = std::min<float>( nearestZ[c], lz - lez );
+            rectMin[c].x = std::min<float>( rectMin[c].x, lx - lex );
+            rectMin[c].y = std::min<float>( rectMin[c].y, ly - ley );
+            rectMax[c].x = std::max<float>( rectMax[c].x, lx + lex );
+            rectMax[c].y = std::max<float>( rectMax[c].y, ly + ley );
+        }
+    }
+
+    for ( int c = 0; c < mCascadeCount; ++c )
+    {
+        ShadowCascade& cascade = mCascades[c];
+        if ( cascade.Casters.empty() )
+        {
+            cascade.Left = cascade.Top = cascade.Right = cascade.Bottom = 0;
+            continue;
+        }
+
+        mNearZ[c] = nearestZ[c];
+
+        // Texel rectangle; texture rows run from +y down to -y.
+        float texelsPerUnit = mShadowMapSize / ( 2.0f * mHalfSize[c] );
+        float left          = mCenter[c].x - mHalfSize[c];
+        float top           = mCenter[c].y + mHalfSize[c];
+        auto  toTexel       = [&]( float v ) {
+            return static_cast<int>( std::min<float>( std::max<float>( v, 0.0f ), float( mShadowMapSize ) ) );
+        };
+        cascade.Left   = toTexel( std::floor( ( rectMin[c].x - left ) * texelsPerUnit ) );
+        cascade.Right  = toTexel( std::ceil( ( rectMax[c].x - left ) * texelsPerUnit ) );
+        cascade.Top    = toTexel( std::floor( ( top - rectMax[c].y ) * texelsPerUnit ) );
+        cascade.Bottom = toTexel( std::ceil( ( top - rectMin[c].y ) * texelsPerUnit ) );
+
+        UpdateProjection( c );
+    }
+}
+
+void CascadedShadows::UpdateProjection( int index )
+{
+    XMMATRIX proj = XMMatrixOrthographicOffCenterLH( mCenter[index].x - mHalfSize[index], mCenter[index].x + mHalfSize[index],
+                                                     mCenter[index].y - mHalfSize[index], mCenter[index].y + mHalfSize[index],
+                                                     mNearZ[index], mFarZ[index] );
+    XMStoreFloat4x4( &mCascades[index].ViewProj, XMMatrixMultiply( XMLoadFloat4x4( &mLightView ), proj ) );
+}
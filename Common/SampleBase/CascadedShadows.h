@@ -0,0 +1,102 @@
+//***************************************************************************************
+// CascadedShadows.h
+//
+// Cascaded shadow maps for a directional light.
+//
+// The camera's view distance is split into cascades with the "practical" scheme, a
+// blend of logarithmic and uniform splits (Zhang et al. 2006).  Each cascade renders
+// the bounding sphere of its slice of the view frustum with an orthographic projection
+// along the light direction:
+//   -the sphere makes the projection size independent of the camera orientation, and
+//   -the projection center is snapped to whole shadow map texels in light space,
+// so shadow edges do not shimmer as the camera moves or turns.
+//
+// CullCasters then tests the casters' bounds against all cascades in one pass over the
+// objects.  Each cascade gets its own caster list, its near plane is pulled in or out to
+// the nearest surviving caster, and a texel-aligned rectangle covering the survivors is
+// computed.  Use that rectangle as the scissor rectangle when drawing the casters; the
+// texels outside it keep the clear value, since nothing casts into them.
+//***************************************************************************************
+
+#pragma once
+
+#include "FrustumCulling.h"
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+class Camera;
+struct Light;
+
+struct ShadowCascadeSettings
+{
+    int CascadeCount = 4;
+
+    // 0 gives uniform splits, 1 logarithmic ones.
+    float SplitLambda = 0.8f;
+
+    // Shadow distance, or 0 for the camera's far plane.
+    float MaxDistance = 0.0f;
+
+    // Resolution of one cascade's shadow map.
+    int ShadowMapSize = 2048;
+
+    // How far toward the light casters are looked for before CullCasters refines it.
+    float CasterDistance = 200.0f;
+};
+
+struct ShadowCascade
+{
+    // Camera view distances covered by the cascade.
+    float SplitNear = 0.0f;
+    float SplitFar  = 0.0f;
+
+    // World to light space rotation times the orthographic projection.
+    DirectX::XMFLOAT4X4 ViewProj;
+
+    // Texel rectangle [Left, Right) x [Top, Bottom) of the shadow map that contains
+    // casters.  The whole map until CullCasters is called.
+    int Left   = 0;
+    int Top    = 0;
+    int Right  = 0;
+    int Bottom = 0;
+
+    // Objects that cast into this cascade, from CullCasters.
+    std::vector<std::uint32_t> Casters;
+};
+
+class CascadedShadows
+{
+public:
+    static const int MaxCascades = 8;
+
+    // Fits the cascades to the camera's current view and the light's direction.
+    void Update( const Camera& camera, const Light& light, const ShadowCascadeSettings& settings = ShadowCascadeSettings() );
+
+    // Culls caster bounds (world space AABBs) against all cascades in one pass, filling
+    // each cascade's Casters and cropping its near plane and texel rectangle.
+    void CullCasters( const BoxBoundsSoA& casters );
+
+    int                  GetCascadeCount() const { return mCascadeCount; }
+    const ShadowCascade& GetCascade( int index ) const { return mCascades[index]; }
+
+private:
+    // Rebuilds ViewProj of a cascade from its light space box.
+    void UpdateProjection( int index );
+
+private:
+    int mCascadeCount  = 0;
+    int mShadowMapSize = 0;
+
+    // World to light space rotation.
+    DirectX::XMFLOAT4X4 mLightView;
+
+    // Light space box of each cascade: the snapped square around the slice's bounding
+    // sphere, and the depth range.
+    DirectX::XMFLOAT2 mCenter[MaxCascades];
+    float             mHalfSize[MaxCascades];
+    float             mNearZ[MaxCascades];
+    float             mFarZ[MaxCascades];
+
+    ShadowCascade mCascades[MaxCascades];
+};
@@ -0,0 +1,45 @@
+//***************************************************************************************
+// Clock.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "Clock.h"
+#include <chrono>
+
+const std::int64_t Clock::NanosecondsPerSecond;
+
+const Clock& Clock::Default()
+{
+#if defined( _WIN32 )
+    static const QpcClock clock;
+#else
+    static const SteadyClock clock;
+#endif
+    return clock;
+}
+
+#if defined( _WIN32 )
+QpcClock::QpcClock()
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency( &frequency );
+    mFrequency = frequency.QuadPart;
+}
+
+std::int64_t QpcClock::Now() const
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter( &counter );
+
+    // Whole seconds and the remainder separately, so that counter * 1e9 cannot overflow.
+    std::int64_t seconds   = counter.QuadPart / mFrequency;
+    std::int64_t remainder = counter.QuadPart % mFrequency;
+    return seconds * NanosecondsPerSecond + remainder * NanosecondsPerSecond / mFrequency;
+}
+#endif
+
+std::int64_t SteadyClock::Now() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
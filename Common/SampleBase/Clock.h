@@ -0,0 +1,62 @@
+//***************************************************************************************
+// Clock.h
+//
+// Monotonic time sources for GameTimer and frame measurements.
+//
+// Time is an int64 count of nanoseconds from an arbitrary origin, which keeps full
+// precision for 292 years of uptime.  Reading a clock is one virtual call on top of the
+// platform query: QueryPerformanceCounter on Windows and std::chrono::steady_clock
+// elsewhere, which is clock_gettime( CLOCK_MONOTONIC ) served from the vDSO on Linux,
+// so neither enters the kernel.  ManualClock only moves when told to, for tests.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+
+class Clock
+{
+public:
+    static const std::int64_t NanosecondsPerSecond = 1000000000;
+
+    virtual ~Clock() {}
+
+    // Current time in nanoseconds.
+    virtual std::int64_t Now() const = 0;
+
+    // The platform's high resolution clock, shared by the process.
+    static const Clock& Default();
+};
+
+#if defined( _WIN32 )
+class QpcClock : public Clock
+{
+public:
+    QpcClock();
+
+    std::int64_t Now() const override;
+
+private:
+    std::int64_t mFrequency = 1;
+};
+#endif
+
+class SteadyClock : public Clock
+{
+public:
+    std::int64_t Now() const override;
+};
+
+class ManualClock : public Clock
+{
+public:
+    explicit ManualClock( std::int64_t now = 0 ) : mNow( now ) {}
+
+    std::int64_t Now() const override { return mNow; }
+
+    void Set( std::int64_t now ) { mNow = now; }
+    void Advance( std::int64_t nanoseconds ) { mNow += nanoseconds; }
+
+private:
+    std::int64_t mNow;
+};
@@ -0,0 +1,63 @@
+//***************************************************************************************
+// CpuFeatures.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "CpuFeatures.h"
+#include <intrin.h>
+
+bool CpuFeatures::HasSSE41()
+{
+    return Get().SSE41;
+}
+
+bool CpuFeatures::HasAVX2()
+{
+    return Get().AVX2;
+}
+
+bool CpuFeatures::HasF16C()
+{
+    return Get().F16C;
+}
+
+const CpuFeatures::Flags& CpuFeatures::Get()
+{
+    static const Flags flags = []() {
+        Flags f;
+
+        int info[4] = { 0, 0, 0, 0 };
+        __cpuid( info, 0 );
+        int maxLeaf = info[0];
+
+        if ( maxLeaf < 1 )
+            return f;
+
+        __cpuid( info, 1 );
+        bool sse41   = ( info[2] & ( 1 << 19 ) ) != 0;
+        bool fma     = ( info[2] & ( 1 << 12 ) ) != 0;
+        bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+        bool avx     = ( info[2] & ( 1 << 28 ) ) != 0;
+        bool f16c    = ( info[2] & ( 1 << 29 ) ) != 0;
+
+        // The OS must save XMM and YMM state for any AVX instruction to be usable.
+        bool ymmEnabled = false;
+        if ( osxsave && avx )
+            ymmEnabled = ( _xgetbv( 0 ) & 0x6 ) == 0x6;
+
+        bool avx2 = false;
+        if ( maxLeaf >= 7 )
+        {
+            __cpuidex( info, 7, 0 );
+            avx2 = ( info[1] & ( 1 << 5 ) ) != 0;
+        }
+
+        f.SSE41 = sse41;
+        f.AVX2  = ymmEnabled && avx2 && fma;
+        f.F16C  = ymmEnabled && f16c;
+        return f;
+    }();
+
+    return flags;
+}
@@ -0,0 +1,32 @@
+//***************************************************************************************
+// CpuFeatures.h
+//
+// Runtime detection of optional instruction set extensions.  Batch kernels use
+// this to pick an AVX2/F16C code path when the CPU and OS support it and fall
+// back to SSE or scalar code otherwise.
+//***************************************************************************************
+
+#pragma once
+
+class CpuFeatures
+{
+public:
+    // SSE4.1 (blend/round/dot product instructions).
+    static bool HasSSE41();
+
+    // AVX2 and FMA3, and the OS saves the YMM registers on context switches.
+    static bool HasAVX2();
+
+    // F16C half precision conversion instructions (implies AVX support).
+    static bool HasF16C();
+
+private:
+    struct Flags
+    {
+        bool SSE41 = false;
+        bool AVX2  = false;
+        bool F16C  = false;
+    };
+
+    static const Flags& Get();
+};
@@ -0,0 +1,66 @@
+//***************************************************************************************
+// DynamicResolution.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+DynamicResolution::DynamicResolution( const DynamicResolutionSettings& settings )
+{
+    SetSettings( settings );
+}
+
+void DynamicResolution::SetSettings( const DynamicResolutionSettings& settings )
+{
+    assert( settings.TargetFrameMs > 0.0f );
+    assert( settings.MinScale > 0.0f && settings.MinScale <= settings.MaxScale );
+    assert( settings.ScaleStep > 0.0f );
+
+    mSettings = settings;
+    Reset();
+}
+
+void DynamicResolution::Reset()
+{
+    mLogScale      = std::log( mSettings.MaxScale );
+    mPreviousError = 0.0f;
+    mScale         = mSettings.MaxScale;
+}
+
+float DynamicResolution::Update( const FrameTimes& times )
+{
+    if ( times.GpuMs <= 0.0f )
+        return mScale;
+
+    float ratio = mSettings.TargetFrameMs / times.GpuMs;
+    float error = std::fabs( ratio - 1.0f ) < mSettings.DeadZone ? 0.0f : 0.5f * std::log( ratio );
+
+    // CPU bound: a lower resolution would not bring the frame under the target.
+    if ( times.CpuMs > mSettings.TargetFrameMs )
+        error = std::max<float>( error, 0.0f );
+
+    float gainScale = error > 0.0f ? mSettings.IncreaseGainScale : 1.0f;
+    mLogScale += gainScale * ( mSettings.ProportionalGain * ( error - mPreviousError ) + mSettings.IntegralGain * error );
+    mLogScale      = std::min<float>( std::max<float>( mLogScale, std::log( mSettings.MinScale ) ), std::log( mSettings.MaxScale ) );
+    mPreviousError = error;
+
+    // Move the applied scale only once the controller is most of a step away from it,
+    // so that it does not toggle between two steps.
+    float scale = std::exp( mLogScale );
+    if ( std::fabs( scale - mScale ) > 0.75f * mSettings.ScaleStep || scale <= mSettings.MinScale || scale >= mSettings.MaxScale )
+    {
+        float quantized = std::round( scale / mSettings.ScaleStep ) * mSettings.ScaleStep;
+        mScale          = std::min<float>( std::max<float>( quantized, mSettings.MinScale ), mSettings.MaxScale );
+    }
+
+    return mScale;
+}
+
+int DynamicResolution::GetScaledSize( int size ) const
+{
+    return std::max<int>( static_cast<int>( size * mScale + 0.5f ), 1 );
+}
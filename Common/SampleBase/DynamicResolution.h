@@ -0,0 +1,108 @@
+//***************************************************************************************
+// DynamicResolution.h
+//
+// Render scale controller that holds a frame time budget.
+//
+// GPU time grows roughly with the number of pixels shaded, i.e. with the square of the
+// render scale s, so the scale that exactly meets the target is s * sqrt( target / t ).
+// The controller works on log( s ), where that correction becomes the additive error
+//
+//   e = 0.5 * log( target / t )
+//
+// and applies a PI controller in velocity form, which cannot wind up against the scale
+// limits.  Frame times within a dead zone around the target give no error, so ordinary
+// frame-to-frame noise does not move the scale, and the applied scale only changes in
+// whole steps.  Over budget the gains are larger than under it: a load spike is shed
+// within a few frames, while resolution comes back slowly once the load is gone.
+//
+// Frame times are pulled from a FrameTimeSource, so that tests can drive the controller
+// with simulated times.  The controller drives the render scale with the GPU time only:
+// CPU time is not affected by resolution, so while it alone is over the target the scale
+// is never lowered, and while the GPU time is not measured the scale holds.
+//***************************************************************************************
+
+#pragma once
+
+struct FrameTimes
+{
+    float CpuMs = 0.0f;
+
+    // 0 if the GPU time is not measured.
+    float GpuMs = 0.0f;
+};
+
+class FrameTimeSource
+{
+public:
+    virtual ~FrameTimeSource() {}
+
+    // Times of the last completed frame.
+    virtual FrameTimes GetFrameTimes() = 0;
+};
+
+// Returns whatever was last set, e.g. from timestamp queries or a simulation.
+class ManualFrameTimeSource : public FrameTimeSource
+{
+public:
+    void SetFrameTimes( const FrameTimes& times ) { mTimes = times; }
+    void SetCpuMs( float ms ) { mTimes.CpuMs = ms; }
+    void SetGpuMs( float ms ) { mTimes.GpuMs = ms; }
+
+    FrameTimes GetFrameTimes() override { return mTimes; }
+
+private:
+    FrameTimes mTimes;
+};
+
+struct DynamicResolutionSettings
+{
+    float TargetFrameMs = 16.0f;
+
+    // Limits of the render scale, applied to width and height.
+    float MinScale = 0.5f;
+    float MaxScale = 1.0f;
+
+    // Granularity of the applied scale.
+    float ScaleStep = 1.0f / 32.0f;
+
+    // Relative distance from the target within which frame times are left alone.
+    float DeadZone = 0.05f;
+
+    // Proportional and integral gains, with the factor they are scaled by while the
+    // frame time is under the target.
+    float ProportionalGain  = 0.4f;
+    float IntegralGain      = 0.3f;
+    float IncreaseGainScale = 0.25f;
+};
+
+class DynamicResolution
+{
+public:
+    explicit DynamicResolution( const DynamicResolutionSettings& settings = DynamicResolutionSettings() );
+
+    const DynamicResolutionSettings& GetSettings() const { return mSettings; }
+    void                             SetSettings( const DynamicResolutionSettings& settings );
+
+    // Feeds one frame's times and returns the render scale to use for the next frame.
+    // Frames without a GPU time leave the scale unchanged.
+    float Update( const FrameTimes& times );
+    float Update( FrameTimeSource& source ) { return Update( source.GetFrameTimes() ); }
+
+    // Goes back to the largest scale and forgets the controller state.
+    void Reset();
+
+    // Applied (quantized) render scale.
+    float GetScale() const { return mScale; }
+
+    // A full size dimension (width or height) at the current scale, at least 1.
+    int GetScaledSize( int size ) const;
+
+private:
+    DynamicResolutionSettings mSettings;
+
+    // Unquantized log scale and the previous error, the controller state.
+    float mLogScale      = 0.0f;
+    float mPreviousError = 0.0f;
+
+    float mScale = 1.0f;
+};
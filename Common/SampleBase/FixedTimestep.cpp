@@ -0,0 +1,66 @@
+//***************************************************************************************
+// FixedTimestep.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "FixedTimestep.h"
+#include "Clock.h"
+#include <cassert>
+
+FixedTimestep::FixedTimestep( std::int64_t stepNanoseconds, int maxStepsPerFrame )
+    : mStep( stepNanoseconds )
+    , mMaxStepsPerFrame( maxStepsPerFrame )
+{
+    assert( stepNanoseconds > 0 );
+    assert( maxStepsPerFrame >= 1 );
+}
+
+void FixedTimestep::SetStep( std::int64_t stepNanoseconds )
+{
+    assert( stepNanoseconds > 0 );
+
+    // Keep the same fraction of a step, so the interpolation does not jump.
+    mAccumulator = static_cast<std::int64_t>( GetAlpha() * stepNanoseconds );
+    mStep        = stepNanoseconds;
+}
+
+void FixedTimestep::SetMaxStepsPerFrame( int maxSteps )
+{
+    assert( maxSteps >= 1 );
+    mMaxStepsPerFrame = maxSteps;
+}
+
+int FixedTimestep::Advance( std::int64_t elapsedNanoseconds )
+{
+    if ( elapsedNanoseconds > 0 )
+        mAccumulator += elapsedNanoseconds;
+
+    std::int64_t steps = mAccumulator / mStep;
+    if ( steps > mMaxStepsPerFrame )
+    {
+        // Keep the fraction of a step, so the interpolation stays continuous.
+        std::int64_t excess = ( steps - mMaxStepsPerFrame ) * mStep;
+        mDropped     += excess;
+        mAccumulator -= excess;
+        steps        = mMaxStepsPerFrame;
+    }
+
+    mAccumulator -= steps * mStep;
+    return static_cast<int>( steps );
+}
+
+void FixedTimestep::Reset()
+{
+    mAccumulator = 0;
+}
+
+float FixedTimestep::GetStepSeconds() const
+{
+    return static_cast<float>( static_cast<double>( mStep ) / Clock::NanosecondsPerSecond );
+}
+
+float FixedTimestep::GetAlpha() const
+{
+    return static_cast<float>( static_cast<double>( mAccumulator ) / mStep );
+}
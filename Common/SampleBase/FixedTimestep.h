@@ -0,0 +1,51 @@
+//***************************************************************************************
+// FixedTimestep.h
+//
+// Accumulator for running a simulation at a fixed rate, independent of the frame rate.
+//
+// Each frame adds its elapsed time to the accumulator, and the simulation advances one
+// fixed step for every whole step that has accumulated.  What is left over, as a
+// fraction of a step, is the interpolation alpha between the last two simulation states
+// to render with, so motion stays smooth when the two rates do not match.
+//
+// If the simulation cannot keep up, every frame would need more steps than the last
+// (the "spiral of death").  The steps per frame are capped instead, and the time that
+// did not fit is dropped: the simulation slows down rather than the frame rate
+// collapsing.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+
+class FixedTimestep
+{
+public:
+    // 60 Hz, at most 8 steps per frame.
+    explicit FixedTimestep( std::int64_t stepNanoseconds = 16666667, int maxStepsPerFrame = 8 );
+
+    void SetStep( std::int64_t stepNanoseconds );
+    void SetMaxStepsPerFrame( int maxSteps );
+
+    // Adds a frame's elapsed time and returns the number of steps to simulate.
+    int Advance( std::int64_t elapsedNanoseconds );
+
+    // Forgets accumulated time, e.g. after loading or unpausing.
+    void Reset();
+
+    std::int64_t GetStepNanoseconds() const { return mStep; }
+    float        GetStepSeconds() const;
+
+    // Fraction of a step accumulated beyond the last simulated one, in [0, 1).
+    float GetAlpha() const;
+
+    // Total time dropped because the step cap was hit.
+    std::int64_t GetDroppedNanoseconds() const { return mDropped; }
+
+private:
+    std::int64_t mStep;
+    int          mMaxStepsPerFrame;
+
+    std::int64_t mAccumulator = 0;
+    std::int64_t mDropped     = 0;
+};
@@ -0,0 +1,303 @@
+//***************************************************************************************
+// FrameStatistics.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "FrameStatistics.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+const std::uint32_t FrameStatistics::HistorySize;
+
+namespace
+{
+    const int RecordBufferSize = 1024;
+
+    const char* CsvHeader = "time,frames,fps,low1_fps,"
+                            "frame_mean,frame_p50,frame_p95,frame_p99,frame_max,"
+                            "cpu_mean,cpu_p50,cpu_p95,cpu_p99,cpu_max,"
+                            "gpu_mean,gpu_p50,gpu_p95,gpu_p99,gpu_max\n";
+} // namespace
+
+P2Quantile::P2Quantile( double quantile ) : mQuantile( quantile )
+{
+    assert( quantile > 0.0 && quantile < 1.0 );
+    Reset();
+}
+
+void P2Quantile::Reset()
+{
+    const double p = mQuantile;
+
+    mCount = 0;
+    for ( int i = 0; i < 5; ++i )
+    {
+        mHeights[i]   = 0.0;
+        mPositions[i] = i;
+    }
+
+    mDesired[0] = 0.0;
+    mDesired[1] = 2.0 * p;
+    mDesired[2] = 4.0 * p;
+    mDesired[3] = 2.0 + 2.0 * p;
+    mDesired[4] = 4.0;
+
+    mIncrements[0] = 0.0;
+    mIncrements[1] = 0.5 * p;
+    mIncrements[2] = p;
+    mIncrements[3] = 0.5 * ( 1.0 + p );
+    mIncrements[4] = 1.0;
+}
+
+void P2Quantile::Add( double value )
+{
+    // The first 5 values become the initial markers.
+    if ( mCount < 5 )
+    {
+        mHeights[mCount++] = value;
+        if ( mCount == 5 )
+            std::sort( mHeights, mHeights + 5 );
+        return;
+    }
+    ++mCount;
+
+    // Cell of the new value, extending the extreme markers if needed.
+    int k;
+    if ( value < mHeights[0] )
+    {
+        mHeights[0] = value;
+        k           = 0;
+    }
+    else if ( value >= mHeights[4] )
+    {
+        mHeights[4] = value;
+        k           = 3;
+    }
+    else
+    {
+        k = 0;
+        while ( value >= mHeights[k + 1] )
+            ++k;
+    }
+
+    for ( int i = k + 1; i < 5; ++i )
+        mPositions[i] += 1.0;
+    for ( int i = 0; i < 5; ++i )
+        mDesired[i] += mIncrements[i];
+
+    // Move the middle markers toward their desired positions, with the piecewise
+    // parabolic formula, or linearly where that would break the ordering.
+    for ( int i = 1; i < 4; ++i )
+    {
+        double d = mDesired[i] - mPositions[i];
+        if ( ( d >= 1.0 && mPositions[i + 1] - mPositions[i] > 1.0 ) || ( d <= -1.0 && mPositions[i - 1] - mPositions[i] < -1.0 ) )
+        {
+            double s = d > 0.0 ? 1.0 : -1.0;
+
+            double q = mHeights[i] + s / ( mPositions[i + 1] - mPositions[i - 1] ) *
+                                         ( ( mPositions[i] - mPositions[i - 1] + s ) * ( mHeights[i + 1] - mHeights[i] ) / ( mPositions[i + 1] - mPositions[i] ) +
+                                           ( mPositions[i + 1] - mPositions[i] - s ) * ( mHeights[i] - mHeights[i - 1] ) / ( mPositions[i] - mPositions[i - 1] ) );
+            if ( q <= mHeights[i - 1] || q >= mHeights[i + 1] )
+            {
+                int j = i + static_cast<int>( s );
+                q     = mHeights[i] + s * ( mHeights[j] - mHeights[i] ) / ( mPositions[j] - mPositions[i] );
+            }
+
+            mHeights[i] = q;
+            mPositions[i] += s;
+        }
+    }
+}
+
+double P2Quantile::Get() const
+{
+    if ( mCount == 0 )
+        return 0.0;
+
+    if ( mCount < 5 )
+    {
+        double sorted[5];
+        std::copy( mHeights, mHeights + mCount, sorted );
+        std::sort( sorted, sorted + mCount );
+        return sorted[static_cast<size_t>( mQuantile * ( mCount - 1 ) + 0.5 )];
+    }
+
+    return mHeights[2];
+}
+
+FrameStatistics::Channel::Channel() : P50( 0.50 ), P95( 0.95 ), P99( 0.99 )
+{
+}
+
+void FrameStatistics::Channel::Add( float ms )
+{
+    Sum += ms;
+    Max = std::max<float>( Max, ms );
+    P50.Add( ms );
+    P95.Add( ms );
+    P99.Add( ms );
+}
+
+void FrameStatistics::Channel::Reset()
+{
+    Sum = 0.0;
+    Max = 0.0f;
+    P50.Reset();
+    P95.Reset();
+    P99.Reset();
+}
+
+FrameTimeSummary FrameStatistics::Channel::Summarize() const
+{
+    FrameTimeSummary summary;
+    if ( P50.GetCount() > 0 )
+    {
+        summary.Mean = static_cast<float>( Sum / P50.GetCount() );
+        summary.P50  = static_cast<float>( P50.Get() );
+        summary.P95  = static_cast<float>( P95.Get() );
+        summary.P99  = static_cast<float>( P99.Get() );
+        summary.Max  = Max;
+    }
+    return summary;
+}
+
+FrameStatistics::FrameStatistics()
+{
+}
+
+FrameStatistics::~FrameStatistics()
+{
+    CloseExports();
+}
+
+void FrameStatistics::SetWindow( double seconds )
+{
+    assert( seconds > 0.0 );
+    mWindow = seconds;
+}
+
+bool FrameStatistics::AddFrame( double time, const FrameSample& sample )
+{
+    mHistory.Push( sample );
+
+    if ( mWindowStart < 0.0 )
+        mWindowStart = time;
+
+    ++mWindowCount;
+    mFrame.Add( sample.FrameMs );
+    mCpu.Add( sample.CpuMs );
+    mGpu.Add( sample.GpuMs );
+
+    if ( time - mWindowStart < mWindow )
+        return false;
+
+    FinishWindow( time );
+    return true;
+}
+
+std::uint32_t FrameStatistics::CopyHistory( FrameSample* out, std::uint32_t maxCount ) const
+{
+    std::uint64_t end = mHistory.GetCount();
+    return static_cast<std::uint32_t>( mHistory.Copy( end - std::min<std::uint64_t>( end, maxCount ), end, out ) );
+}
+
+bool FrameStatistics::OpenCsv( const char* path )
+{
+    mCsv.close();
+    mCsv.clear();
+    mCsv.open( path, std::ios::out | std::ios::trunc );
+    if ( !mCsv )
+        return false;
+
+    mCsv << CsvHeader;
+    return true;
+}
+
+bool FrameStatistics::OpenJson( const char* path )
+{
+    if ( mJson.is_open() )
+    {
+        mJson << "\n]\n";
+        mJson.close();
+    }
+
+    mJson.clear();
+    mJson.open( path, std::ios::out | std::ios::trunc );
+    if ( !mJson )
+        return false;
+
+    mJson << "[";
+    mJsonEmpty = true;
+    return true;
+}
+
+void FrameStatistics::CloseExports()
+{
+    if ( mCsv.is_open() )
+        mCsv.close();
+
+    if ( mJson.is_open() )
+    {
+        mJson << "\n]\n";
+        mJson.close();
+    }
+}
+
+void FrameStatistics::FinishWindow( double time )
+{
+    FrameStatsReport& report = mLastReport;
+    report.Time              = time;
+    report.FrameCount        = mWindowCount;
+    report.Frame             = mFrame.Summarize();
+    report.Cpu               = mCpu.Summarize();
+    report.Gpu               = mGpu.Summarize();
+    report.AverageFps        = report.Frame.Mean > 0.0f ? 1000.0f / report.Frame.Mean : 0.0f;
+    report.OnePercentLow     = report.Frame.P99 > 0.0f ? 1000.0f / report.Frame.P99 : 0.0f;
+
+    Export( report );
+
+    mWindowStart = time;
+    mWindowCount = 0;
+    mFrame.Reset();
+    mCpu.Reset();
+    mGpu.Reset();
+}
+
+void FrameStatistics::Export( const FrameStatsReport& r )
+{
+    char buffer[RecordBufferSize];
+
+    if ( mCsv.is_open() )
+    {
+        int length = std::snprintf( buffer, sizeof( buffer ),
+                                    "%.3f,%u,%.2f,%.2f,"
+                                    "%.3f,%.3f,%.3f,%.3f,%.3f,"
+                                    "%.3f,%.3f,%.3f,%.3f,%.3f,"
+                                    "%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                                    r.Time, r.FrameCount, r.AverageFps, r.OnePercentLow,
+                                    r.Frame.Mean, r.Frame.P50, r.Frame.P95, r.Frame.P99, r.Frame.Max,
+                                    r.Cpu.Mean, r.Cpu.P50, r.Cpu.P95, r.Cpu.P99, r.Cpu.Max,
+                                    r.Gpu.Mean, r.Gpu.P50, r.Gpu.P95, r.Gpu.P99, r.Gpu.Max );
+        if ( length > 0 )
+            mCsv.write( buffer, std::min<int>( length, RecordBufferSize - 1 ) ).flush();
+    }
+
+    if ( mJson.is_open() )
+    {
+        const char* format = "%s\n  {\"time\": %.3f, \"frames\": %u, \"fps\": %.2f, \"low1_fps\": %.2f, "
+                             "\"frame\": {\"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f}, "
+                             "\"cpu\": {\"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f}, "
+                             "\"gpu\": {\"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f}}";
+
+        int length = std::snprintf( buffer, sizeof( buffer ), format, mJsonEmpty ? "" : ",",
+                                    r.Time, r.FrameCount, r.AverageFps, r.OnePercentLow,
+                                    r.Frame.Mean, r.Frame.P50, r.Frame.P95, r.Frame.P99, r.Frame.Max,
+                                    r.Cpu.Mean, r.Cpu.P50, r.Cpu.P95, r.Cpu.P99, r.Cpu.Max,
+                                    r.Gpu.Mean, r.Gpu.P50, r.Gpu.P95, r.Gpu.P99, r.Gpu.Max );
+        if ( length > 0 )
+            mJson.write( buffer, std::min<int>( length, RecordBufferSize - 1 ) ).flush();
+        mJsonEmpty = false;
+    }
+}
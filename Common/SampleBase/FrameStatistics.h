@@ -0,0 +1,151 @@
+//***************************************************************************************
+// FrameStatistics.h
+//
+// Frame time history and percentile statistics.
+//
+// Average frame rates hide hitches: one 100 ms frame in a second of 10 ms frames barely
+// moves the average, but is plainly visible.  FrameStatistics keeps the frame, CPU and
+// GPU time of every frame:
+//   -in a fixed ring of the last HistorySize frames, written by the frame loop without
+//    locks and readable from any thread, e.g. to draw a frame time graph, and
+//   -in per-window summaries (default 1 second) with mean, p50/p95/p99 and max, where
+//    the percentiles come from P-square streaming estimators (Jain and Chlamtac 1985)
+//    that use constant memory and time per frame.
+// The "1% low" frame rate is 1000 / p99 frame time.
+//
+// Completed windows can be appended to CSV and JSON files.  Records are formatted into a
+// fixed buffer and written to streams opened beforehand, so the frame loop does not
+// allocate.
+//***************************************************************************************
+
+#pragma once
+
+#include "SnapshotRing.h"
+#include <cstdint>
+#include <fstream>
+
+struct FrameSample
+{
+    float FrameMs = 0.0f; // interval from the previous frame
+    float CpuMs   = 0.0f;
+    float GpuMs   = 0.0f;
+};
+
+// Streaming estimate of one quantile with the P-square algorithm.
+class P2Quantile
+{
+public:
+    // quantile in (0, 1), e.g. 0.99.
+    explicit P2Quantile( double quantile );
+
+    void Add( double value );
+    void Reset();
+
+    // The estimate, exact while fewer than 5 values were added.
+    double Get() const;
+
+    std::uint64_t GetCount() const { return mCount; }
+
+private:
+    double        mQuantile;
+    std::uint64_t mCount = 0;
+
+    // Marker heights, actual and desired positions, and desired position increments.
+    double mHeights[5];
+    double mPositions[5];
+    double mDesired[5];
+    double mIncrements[5];
+};
+
+struct FrameTimeSummary
+{
+    float Mean = 0.0f;
+    float P50  = 0.0f;
+    float P95  = 0.0f;
+    float P99  = 0.0f;
+    float Max  = 0.0f;
+};
+
+struct FrameStatsReport
+{
+    // End of the window, in seconds.
+    double        Time       = 0.0;
+    std::uint32_t FrameCount = 0;
+
+    float AverageFps    = 0.0f;
+    float OnePercentLow = 0.0f;
+
+    FrameTimeSummary Frame;
+    FrameTimeSummary Cpu;
+    FrameTimeSummary Gpu;
+};
+
+class FrameStatistics
+{
+public:
+    static const std::uint32_t HistorySize = 1024;
+
+    FrameStatistics();
+    FrameStatistics( const FrameStatistics& rhs ) = delete;
+    FrameStatistics& operator=( const FrameStatistics& rhs ) = delete;
+    ~FrameStatistics();
+
+    // Length of the summary windows in seconds.
+    void SetWindow( double seconds );
+
+    ///<summary>
+    /// Records a frame that ended at time (seconds, e.g. GameTimer::TotalTimeDouble).  Call
+    /// from one thread only.  Returns true when this completes a window; the window's
+    /// report is then available from GetLastReport and has been written to the open
+    /// export files.
+    ///</summary>
+    bool AddFrame( double time, const FrameSample& sample );
+
+    // Copies up to maxCount of the most recent frames, oldest first, and returns how
+    // many were copied.  Safe to call from any thread while frames are added.
+    std::uint32_t CopyHistory( FrameSample* out, std::uint32_t maxCount ) const;
+
+    std::uint64_t           GetFrameCount() const { return mHistory.GetCount(); }
+    const FrameStatsReport& GetLastReport() const { return mLastReport; }
+
+    // Opens a file that every completed window is appended to.  Returns false if the
+    // file cannot be created.
+    bool OpenCsv( const char* path );
+    bool OpenJson( const char* path );
+    void CloseExports();
+
+private:
+    // Estimators of one time series over the current window.
+    struct Channel
+    {
+        Channel();
+        void Add( float ms );
+        void Reset();
+        FrameTimeSummary Summarize() const;
+
+        double     Sum = 0.0;
+        float      Max = 0.0f;
+        P2Quantile P50;
+        P2Quantile P95;
+        P2Quantile P99;
+    };
+
+    void FinishWindow( double time );
+    void Export( const FrameStatsReport& report );
+
+private:
+    SnapshotRing<FrameSample, HistorySize> mHistory;
+
+    double        mWindow      = 1.0;
+    double        mWindowStart = -1.0;
+    std::uint32_t mWindowCount = 0;
+    Channel       mFrame;
+    Channel       mCpu;
+    Channel       mGpu;
+
+    FrameStatsReport mLastReport;
+
+    std::ofstream mCsv;
+    std::ofstream mJson;
+    bool          mJsonEmpty = true;
+};
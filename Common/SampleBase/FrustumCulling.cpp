@@ -0,0 +1,367 @@
+//***************************************************************************************
+// FrustumCulling.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "FrustumCulling.h"
+#include "Camera.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <immintrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+    // Objects per thread pool task; a multiple of the widest vector.
+    const size_t GrainSize = 16384;
+
+    // Arrays are padded so that the last block can be loaded with full vector width.
+    const size_t Padding = 8;
+
+    inline size_t PaddedSize( size_t count )
+    {
+        return ( count + Padding - 1 ) / Padding * Padding;
+    }
+
+    //
+    // Thin wrappers so each test is written once for both vector widths.
+    //
+
+    struct SseOps
+    {
+        typedef __m128 F;
+        static const size_t Width = 4;
+
+        static F Load( const float* p ) { return _mm_loadu_ps( p ); }
+        static F Set( float a ) { return _mm_set1_ps( a ); }
+        static F Add( F a, F b ) { return _mm_add_ps( a, b ); }
+        static F MulAdd( F a, F b, F c ) { return _mm_add_ps( _mm_mul_ps( a, b ), c ); }
+        static F And( F a, F b ) { return _mm_and_ps( a, b ); }
+        static F Or( F a, F b ) { return _mm_or_ps( a, b ); }
+        static F True() { return _mm_castsi128_ps( _mm_set1_epi32( -1 ) ); }
+        static F Bits( int a ) { return _mm_castsi128_ps( _mm_set1_epi32( a ) ); }
+        static F Zero() { return _mm_setzero_ps(); }
+        static void StoreBits( std::int32_t* p, F a ) { _mm_storeu_si128( reinterpret_cast<__m128i*>( p ), _mm_castps_si128( a ) ); }
+        static F GreaterEqual( F a, F b ) { return _mm_cmpge_ps( a, b ); }
+        static int MoveMask( F a ) { return _mm_movemask_ps( a ); }
+    };
+
+    struct AvxOps
+    {
+        typedef __m256 F;
+        static const size_t Width = 8;
+
+        static F Load( const float* p ) { return _mm256_loadu_ps( p ); }
+        static F Set( float a ) { return _mm256_set1_ps( a ); }
+        static F Add( F a, F b ) { return _mm256_add_ps( a, b ); }
+        static F MulAdd( F a, F b, F c ) { return _mm256_fmadd_ps( a, b, c ); }
+        static F And( F a, F b ) { return _mm256_and_ps( a, b ); }
+        static F Or( F a, F b ) { return _mm256_or_ps( a, b ); }
+        static F True() { return _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) ); }
+        static F Bits( int a ) { return _mm256_castsi256_ps( _mm256_set1_epi32( a ) ); }
+        static F Zero() { return _mm256_setzero_ps(); }
+        static void StoreBits( std::int32_t* p, F a ) { _mm256_storeu_si256( reinterpret_cast<__m256i*>( p ), _mm256_castps_si256( a ) ); }
+        static F GreaterEqual( F a, F b ) { return _mm256_cmp_ps( a, b, _CMP_GE_OQ ); }
+        static int MoveMask( F a ) { return _mm256_movemask_ps( a ); }
+    };
+
+    // Appends the indices of the set bits of mask to out without branches: every lane
+    // is written, but the write position only advances for visible ones.
+    inline size_t AppendVisible( int mask, size_t first, size_t laneCount, std::uint32_t* out, size_t n )
+    {
+        for ( size_t k = 0; k < laneCount; ++k )
+        {
+            out[n] = static_cast<std::uint32_t>( first + k );
+            n += ( mask >> k ) & 1;
+        }
+        return n;
+    }
+
+    // Width boxes loaded from the SoA arrays.  A box is outside a plane when its center
+    // is farther behind it than the box's projected radius |n.x| ex + |n.y| ey + |n.z| ez.
+    template <typename Ops>
+    struct BoxBlock
+    {
+        typedef typename Ops::F F;
+
+        F cx, cy, cz, ex, ey, ez;
+
+        BoxBlock( const BoxBoundsSoA& bounds, size_t i )
+            : cx( Ops::Load( bounds.CenterX() + i ) )
+            , cy( Ops::Load( bounds.CenterY() + i ) )
+            , cz( Ops::Load( bounds.CenterZ() + i ) )
+            , ex( Ops::Load( bounds.ExtentX() + i ) )
+            , ey( Ops::Load( bounds.ExtentY() + i ) )
+            , ez( Ops::Load( bounds.ExtentZ() + i ) )
+        {
+        }
+
+        F Inside( const FrustumPlanes& frustum ) const
+        {
+            F inside = Ops::True();
+            for ( const XMFLOAT4& p : frustum.Planes )
+            {
+                F distance = Ops::MulAdd( Ops::Set( p.x ), cx, Ops::MulAdd( Ops::Set( p.y ), cy, Ops::MulAdd( Ops::Set( p.z ), cz, Ops::Set( p.w ) ) ) );
+                F radius   = Ops::MulAdd( Ops::Set( std::fabs( p.x ) ), ex, Ops::MulAdd( Ops::Set( std::fabs( p.y ) ), ey, Ops::MulAdd( Ops::Set( std::fabs( p.z ) ), ez, distance ) ) );
+                inside     = Ops::And( inside, Ops::GreaterEqual( radius, Ops::Set( 0.0f ) ) );
+            }
+            return inside;
+        }
+    };
+
+    template <typename Ops>
+    struct SphereBlock
+    {
+        typedef typename Ops::F F;
+
+        F cx, cy, cz, r;
+
+        SphereBlock( const SphereBoundsSoA& bounds, size_t i )
+            : cx( Ops::Load( bounds.CenterX() + i ) )
+            , cy( Ops::Load( bounds.CenterY() + i ) )
+            , cz( Ops::Load( bounds.CenterZ() + i ) )
+            , r( Ops::Load( bounds.Radius() + i ) )
+        {
+        }
+
+        F Inside( const FrustumPlanes& frustum ) const
+        {
+            F inside = Ops::True();
+            for ( const XMFLOAT4& p : frustum.Planes )
+            {
+                F distance = Ops::MulAdd( Ops::Set( p.x ), cx, Ops::MulAdd( Ops::Set( p.y ), cy, Ops::MulAdd( Ops::Set( p.z ), cz, Ops::Set( p.w ) ) ) );
+                inside     = Ops::And( inside, Ops::GreaterEqual( Ops::Add( distance, r ), Ops::Set( 0.0f ) ) );
+            }
+            return inside;
+        }
+    };
+
+    template <typename Ops, template <typename> class Block, typename Bounds>
+    size_t CullBlocks( const FrustumPlanes& frustum, const Bounds& bounds, size_t begin, size_t end, std::uint32_t* out )
+    {
+        size_t n = 0;
+        for ( size_t i = begin; i < end; i += Ops::Width )
+        {
+            Block<Ops> block( bounds, i );
+            n = AppendVisible( Ops::MoveMask( block.Inside( frustum ) ), i, std::min<size_t>( Ops::Width, end - i ), out, n );
+        }
+        return n;
+    }
+
+    // Tests each block of objects against all views while it is in registers, setting
+    // bit v of an object's mask when it intersects view v.
+    template <typename Ops, template <typename> class Block, typename Bounds>
+    void ClassifyBlocks( const FrustumPlanes* frusta, int viewCount, const Bounds& bounds, size_t begin, size_t end, std::uint8_t* masks )
+    {
+        typedef typename Ops::F F;
+
+        std::int32_t laneMasks[Ops::Width];
+        for ( size_t i = begin; i < end; i += Ops::Width )
+        {
+            Block<Ops> block( bounds, i );
+
+            F viewBits = Ops::Zero();
+            for ( int v = 0; v < viewCount; ++v )
+                viewBits = Ops::Or( viewBits, Ops::And( block.Inside( frusta[v] ), Ops::Bits( 1 << v ) ) );
+
+            Ops::StoreBits( laneMasks, viewBits );
+            for ( size_t k = 0; k < Ops::Width && i + k < end; ++k )
+                masks[i + k] = static_cast<std::uint8_t>( laneMasks[k] );
+        }
+    }
+
+    template <template <typename> class Block, typename Bounds>
+    void CullViewsImpl( const FrustumPlanes* frusta, int viewCount, const Bounds& bounds, std::vector<std::uint8_t>& viewMasks,
+                        std::vector<std::uint32_t>* visible, ThreadPool& pool )
+    {
+        assert( viewCount >= 1 && viewCount <= FrustumCulling::MaxViews );
+
+        const size_t count = bounds.GetCount();
+        const bool   avx2  = CpuFeatures::HasAVX2();
+
+        viewMasks.resize( count );
+        pool.ParallelFor( count, GrainSize, [&]( size_t begin, size_t end ) {
+            if ( avx2 )
+                ClassifyBlocks<AvxOps, Block>( frusta, viewCount, bounds, begin, end, viewMasks.data() );
+            else
+                ClassifyBlocks<SseOps, Block>( frusta, viewCount, bounds, begin, end, viewMasks.data() );
+        } );
+
+        if ( !visible )
+            return;
+
+        // One list per view, built from the masks in parallel across views.
+        pool.ParallelFor( viewCount, 1, [&]( size_t begin, size_t end ) {
+            for ( size_t v = begin; v < end; ++v )
+            {
+                std::vector<std::uint32_t>& list = visible[v];
+                list.resize( count );
+
+                size_t n = 0;
+                for ( size_t i = 0; i < count; ++i )
+                {
+                    list[n] = static_cast<std::uint32_t>( i );
+                    n += ( viewMasks[i] >> v ) & 1;
+                }
+                list.resize( n );
+            }
+        } );
+    }
+
+    // Runs kernel( begin, end, out ) over chunks of the objects in parallel.  Each chunk
+    // writes its visible indices to the start of its own range of visible, and the
+    // chunks are then packed together in order.
+    template <typename Kernel>
+    void CullParallel( size_t count, std::vector<std::uint32_t>& visible, ThreadPool& pool, const Kernel& kernel )
+    {
+        visible.resize( count );
+
+        std::vector<size_t> chunkVisible( ( count + GrainSize - 1 ) / GrainSize );
+        pool.ParallelFor( count, GrainSize, [&]( size_t begin, size_t end ) {
+            chunkVisible[begin / GrainSize] = kernel( begin, end, visible.data() + begin );
+        } );
+
+        size_t total = 0;
+        for ( size_t c = 0; c < chunkVisible.size(); ++c )
+        {
+            const std::uint32_t* chunk = visible.data() + c * GrainSize;
+            std::copy( chunk, chunk + chunkVisible[c], visible.data() + total );
+            total += chunkVisible[c];
+        }
+        visible.resize( total );
+    }
+} // namespace
+
+const int FrustumCulling::MaxViews;
+
+FrustumPlanes XM_CALLCONV FrustumPlanes::FromViewProj( FXMMATRIX viewProj )
+{
+    // With clip = p * M, the columns c of M give -w <= x <= w as c3 + c0 >= 0 and
+    // c3 - c0 >= 0, and similarly for y, while 0 <= z <= w gives c2 and c3 - c2.
+    XMMATRIX c = XMMatrixTranspose( viewProj );
+
+    XMVECTOR planes[6] = {
+        XMVectorAdd( c.r[3], c.r[0] ),      // left
+        XMVectorSubtract( c.r[3], c.r[0] ), // right
+        XMVectorAdd( c.r[3], c.r[1] ),      // bottom
+        XMVectorSubtract( c.r[3], c.r[1] ), // top
+        c.r[2],                             // near
+        XMVectorSubtract( c.r[3], c.r[2] ), // far
+    };
+
+    FrustumPlanes frustum;
+    for ( int i = 0; i < 6; ++i )
+        XMStoreFloat4( &frustum.Planes[i], XMPlaneNormalize( planes[i] ) );
+    return frustum;
+}
+
+FrustumPlanes FrustumPlanes::FromCamera( const Camera& camera )
+{
+    return FromViewProj( camera.GetViewProj() );
+}
+
+void BoxBoundsSoA::Clear()
+{
+    mCount = 0;
+    mCenterX.clear();
+    mCenterY.clear();
+    mCenterZ.clear();
+    mExtentX.clear();
+    mExtentY.clear();
+    mExtentZ.clear();
+}
+
+size_t BoxBoundsSoA::Add( const BoundingBox& box )
+{
+    size_t index = mCount++;
+    if ( mCount > mCenterX.size() )
+    {
+        size_t size = PaddedSize( mCount );
+        mCenterX.resize( size, 0.0f );
+        mCenterY.resize( size, 0.0f );
+        mCenterZ.resize( size, 0.0f );
+        mExtentX.resize( size, 0.0f );
+        mExtentY.resize( size, 0.0f );
+        mExtentZ.resize( size, 0.0f );
+    }
+
+    Set( index, box );
+    return index;
+}
+
+void BoxBoundsSoA::Set( size_t index, const BoundingBox& box )
+{
+    assert( index < mCount );
+    mCenterX[index] = box.Center.x;
+    mCenterY[index] = box.Center.y;
+    mCenterZ[index] = box.Center.z;
+    mExtentX[index] = box.Extents.x;
+    mExtentY[index] = box.Extents.y;
+    mExtentZ[index] = box.Extents.z;
+}
+
+void SphereBoundsSoA::Clear()
+{
+    mCount = 0;
+    mCenterX.clear();
+    mCenterY.clear();
+    mCenterZ.clear();
+    mRadius.clear();
+}
+
+size_t SphereBoundsSoA::Add( const BoundingSphere& sphere )
+{
+    size_t index = mCount++;
+    if ( mCount > mCenterX.size() )
+    {
+        size_t size = PaddedSize( mCount );
+        mCenterX.resize( size, 0.0f );
+        mCenterY.resize( size, 0.0f );
+        mCenterZ.resize( size, 0.0f );
+        mRadius.resize( size, 0.0f );
+    }
+
+    Set( index, sphere );
+    return index;
+}
+
+void SphereBoundsSoA::Set( size_t index, const BoundingSphere& sphere )
+{
+    assert( index < mCount );
+    mCenterX[index] = sphere.Center.x;
+    mCenterY[index] = sphere.Center.y;
+    mCenterZ[index] = sphere.Center.z;
+    mRadius[index]  = sphere.Radius;
+}
+
+void FrustumCulling::Cull( const FrustumPlanes& frustum, const BoxBoundsSoA& bounds, std::vector<std::uint32_t>& visible, ThreadPool& pool )
+{
+    const bool avx2 = CpuFeatures::HasAVX2();
+    CullParallel( bounds.GetCount(), visible, pool, [&]( size_t begin, size_t end, std::uint32_t* out ) {
+        return avx2 ? CullBlocks<AvxOps, BoxBlock>( frustum, bounds, begin, end, out ) : CullBlocks<SseOps, BoxBlock>( frustum, bounds, begin, end, out );
+    } );
+}
+
+void FrustumCulling::Cull( const FrustumPlanes& frustum, const SphereBoundsSoA& bounds, std::vector<std::uint32_t>& visible, ThreadPool& pool )
+{
+    const bool avx2 = CpuFeatures::HasAVX2();
+    CullParallel( bounds.GetCount(), visible, pool, [&]( size_t begin, size_t end, std::uint32_t* out ) {
+        return avx2 ? CullBlocks<AvxOps, SphereBlock>( frustum, bounds, begin, end, out ) : CullBlocks<SseOps, SphereBlock>( frustum, bounds, begin, end, out );
+    } );
+}
+
+void FrustumCulling::CullViews( const FrustumPlanes* frusta, int viewCount, const BoxBoundsSoA& bounds, std::vector<std::uint8_t>& viewMasks,
+                                std::vector<std::uint32_t>* visible, ThreadPool& pool )
+{
+    CullViewsImpl<BoxBlock>( frusta, viewCount, bounds, viewMasks, visible, pool );
+}
+
+void FrustumCulling::CullViews( const FrustumPlanes* frusta, int viewCount, const SphereBoundsSoA& bounds, std::vector<std::uint8_t>& viewMasks,
+                                std::vector<std::uint32_t>* visible, ThreadPool& pool )
+{
+    CullViewsImpl<SphereBlock>( frusta, viewCount, bounds, viewMasks, visible, pool );
+}
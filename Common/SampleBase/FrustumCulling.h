@@ -0,0 +1,119 @@
+//***************************************************************************************
+// FrustumCulling.h
+//
+// Batched view frustum culling of object bounds.
+//
+// Bounds are kept in structure-of-arrays form so that 8 (AVX2) or 4 (SSE) objects are
+// tested against each plane with a few vector instructions.  The result is a compact
+// list of the indices of the visible objects, in increasing order, ready to drive the
+// draw loop.  Large sets are split across the thread pool.  CullViews tests a set
+// against several frusta in one pass and reports a per-object view mask.
+//
+// The tests are conservative: an object is culled only when it lies entirely outside
+// one of the planes, so a few objects near the frustum corners are reported visible.
+//***************************************************************************************
+
+#pragma once
+
+#include "ThreadPool.h"
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <vector>
+
+class Camera;
+
+// The 6 planes of a view frustum (left, right, bottom, top, near, far) as (n, d) with
+// unit normals pointing inwards, i.e. dot( n, p ) + d >= 0 for points inside.
+struct FrustumPlanes
+{
+    DirectX::XMFLOAT4 Planes[6];
+
+    // Extracts the planes of a D3D style (row vector, clip z in [0, w]) view-projection
+    // matrix.  Planes are in the space that the matrix transforms from, e.g. world
+    // space for view * proj.
+    static FrustumPlanes XM_CALLCONV FromViewProj( DirectX::FXMMATRIX viewProj );
+
+    // World space planes of the camera's current view and lens.
+    static FrustumPlanes FromCamera( const Camera& camera );
+};
+
+// Axis-aligned boxes in SoA form (center and extents), e.g. SubmeshGeometry::Bounds
+// transformed to world space.
+class BoxBoundsSoA
+{
+public:
+    void   Clear();
+    size_t GetCount() const { return mCount; }
+
+    // Returns the index of the new box.
+    size_t Add( const DirectX::BoundingBox& box );
+    void   Set( size_t index, const DirectX::BoundingBox& box );
+
+    // The arrays are padded with zeros to a multiple of 8 entries.
+    const float* CenterX() const { return mCenterX.data(); }
+    const float* CenterY() const { return mCenterY.data(); }
+    const float* CenterZ() const { return mCenterZ.data(); }
+    const float* ExtentX() const { return mExtentX.data(); }
+    const float* ExtentY() const { return mExtentY.data(); }
+    const float* ExtentZ() const { return mExtentZ.data(); }
+
+private:
+    size_t mCount = 0;
+
+    std::vector<float> mCenterX;
+    std::vector<float> mCenterY;
+    std::vector<float> mCenterZ;
+    std::vector<float> mExtentX;
+    std::vector<float> mExtentY;
+    std::vector<float> mExtentZ;
+};
+
+// Spheres in SoA form.
+class SphereBoundsSoA
+{
+public:
+    void   Clear();
+    size_t GetCount() const { return mCount; }
+
+    // Returns the index of the new sphere.
+    size_t Add( const DirectX::BoundingSphere& sphere );
+    void   Set( size_t index, const DirectX::BoundingSphere& sphere );
+
+    // The arrays are padded with zeros to a multiple of 8 entries.
+    const float* CenterX() const { return mCenterX.data(); }
+    const float* CenterY() const { return mCenterY.data(); }
+    const float* CenterZ() const { return mCenterZ.data(); }
+    const float* Radius() const { return mRadius.data(); }
+
+private:
+    size_t mCount = 0;
+
+    std::vector<float> mCenterX;
+    std::vector<float> mCenterY;
+    std::vector<float> mCenterZ;
+    std::vector<float> mRadius;
+};
+
+class FrustumCulling
+{
+public:
+    static const int MaxViews = 8;
+
+    // Replaces visible with the indices of the objects that intersect the frustum.
+    static void Cull( const FrustumPlanes& frustum, const BoxBoundsSoA& bounds, std::vector<std::uint32_t>& visible,
+                      ThreadPool& pool = ThreadPool::Default() );
+    static void Cull( const FrustumPlanes& frustum, const SphereBoundsSoA& bounds, std::vector<std::uint32_t>& visible,
+                      ThreadPool& pool = ThreadPool::Default() );
+
+    ///<summary>
+    /// Culls against up to MaxViews frusta at once, e.g. the 6 faces of a cube map, the
+    /// two eyes of a stereo pair or the players of a split screen.  Each object's bounds
+    /// are loaded once and tested against every view.  viewMasks[i] gets bit v set when
+    /// object i intersects frusta[v].  If visible is not null, visible[v] is replaced with
+    /// the indices of the objects in view v, ready to use as that view's draw list.
+    ///</summary>
+    static void CullViews( const FrustumPlanes* frusta, int viewCount, const BoxBoundsSoA& bounds, std::vector<std::uint8_t>& viewMasks,
+                           std::vector<std::uint32_t>* visible = nullptr, ThreadPool& pool = ThreadPool::Default() );
+    static void CullViews( const FrustumPlanes* frusta, int viewCount, const SphereBoundsSoA& bounds, std::vector<std::uint8_t>& viewMasks,
+                           std::vector<std::uint32_t>* visible = nullptr, ThreadPool& pool = ThreadPool::Default() );
+};
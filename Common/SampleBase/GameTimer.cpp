@@ -6,17 +6,40 @@
 
 #include "GameTimer.h"
 
-GameTimer::GameTimer() :
-    mSecondsPerCount( 0.0 ), mDeltaTime( -1.0 ), mBaseTime( 0 ), mPausedTime( 0 ), mPrevTime( 0 ), mCurrTime( 0 ), mStopped( false )
+GameTimer::GameTimer( const Clock* clock ) :
+    mClock( clock ? clock : &Clock::Default() ), mDeltaTime( 0 ), mBaseTime( 0 ), mPausedTime( 0 ), mStopTime( 0 ), mPrevTime( 0 ), mCurrTime( 0 ),
+    mStopped( false )
 {
-    __int64 countsPerSec;
-    QueryPerformanceFrequency( (LARGE_INTEGER*)&countsPerSec );
-    mSecondsPerCount = 1.0 / (double)countsPerSec;
+}
+
+float GameTimer::TotalTime() const
+{
+    return (float)TotalTimeDouble();
+}
+
+float GameTimer::DeltaTime() const
+{
+    return (float)DeltaTimeDouble();
+}
+
+double GameTimer::TotalTimeDouble() const
+{
+    return (double)TotalNanoseconds() / Clock::NanosecondsPerSecond;
+}
+
+double GameTimer::DeltaTimeDouble() const
+{
+    return (double)mDeltaTime / Clock::NanosecondsPerSecond;
+}
+
+std::int64_t GameTimer::DeltaNanoseconds() const
+{
+    return mDeltaTime;
 }
 
 // Returns the total time elapsed since Reset() was called, NOT counting any
 // time when the clock is stopped.
-float GameTimer::TotalTime() const
+std::int64_t GameTimer::TotalNanoseconds() const
 {
     // If we are stopped, do not count the time that has passed since we stopped.
     // Moreover, if we previously already had a pause, the distance
@@ -29,7 +52,7 @@ float GameTimer::TotalTime() const
 
     if ( mStopped )
     {
-        return (float)( ( ( mStopTime - mPausedTime ) - mBaseTime ) * mSecondsPerCount );
+        return ( mStopTime - mPausedTime ) - mBaseTime;
     }
 
     // The distance mCurrTime - mBaseTime includes paused time,
@@ -44,30 +67,25 @@ float GameTimer::TotalTime() const
 
     else
     {
-        return (float)( ( ( mCurrTime - mPausedTime ) - mBaseTime ) * mSecondsPerCount );
+        return ( mCurrTime - mPausedTime ) - mBaseTime;
     }
 }
 
-float GameTimer::DeltaTime() const
-{
-    return (float)mDeltaTime;
-}
-
 void GameTimer::Reset()
 {
-    __int64 currTime;
-    QueryPerformanceCounter( (LARGE_INTEGER*)&currTime );
-
-    mBaseTime = currTime;
-    mPrevTime = currTime;
-    mStopTime = 0;
-    mStopped  = false;
+    std::int64_t currTime = mClock->Now();
+
+    mBaseTime   = currTime;
+    mPrevTime   = currTime;
+    mCurrTime   = currTime;
+    mPausedTime = 0;
+    mStopTime   = 0;
+    mStopped    = false;
 }
 
 void GameTimer::Start()
 {
-    __int64 startTime;
-    QueryPerformanceCounter( (LARGE_INTEGER*)&startTime );
+    std::int64_t startTime = mClock->Now();
 
 
     // Accumulate the time elapsed between stop and start pairs.
@@ -90,8 +108,7 @@ void GameTimer::Stop()
 {
     if ( !mStopped )
     {
-        __int64 currTime;
-        QueryPerformanceCounter( (LARGE_INTEGER*)&currTime );
+        std::int64_t currTime = mClock->Now();
 
         mStopTime = currTime;
         mStopped  = true;
@@ -102,16 +119,15 @@ void GameTimer::Tick()
 {
     if ( mStopped )
     {
-        mDeltaTime = 0.0;
+        mDeltaTime = 0;
         return;
     }
 
-    __int64 currTime;
-    QueryPerformanceCounter( (LARGE_INTEGER*)&currTime );
+    std::int64_t currTime = mClock->Now();
     mCurrTime = currTime;
 
     // Time difference between this frame and the previous.
-    mDeltaTime = ( mCurrTime - mPrevTime ) * mSecondsPerCount;
+    mDeltaTime = mCurrTime - mPrevTime;
 
     // Prepare for next frame.
     mPrevTime = mCurrTime;
@@ -119,8 +135,8 @@ void GameTimer::Tick()
     // Force nonnegative.  The DXSDK's CDXUTTimer mentions that if the
     // processor goes into a power save mode or we get shuffled to another
     // processor, then mDeltaTime can be negative.
-    if ( mDeltaTime < 0.0 )
+    if ( mDeltaTime < 0 )
     {
-        mDeltaTime = 0.0;
+        mDeltaTime = 0;
     }
 }
@@ -5,30 +5,45 @@
 #ifndef GAMETIMER_H
 #define GAMETIMER_H
 
+#include "Clock.h"
+#include <cstdint>
+
 class GameTimer
 {
 public:
-    GameTimer();
+    // Reads time from clock, or from Clock::Default() if null.  The clock must outlive
+    // the timer.
+    explicit GameTimer(const Clock* clock = nullptr);
 
     float TotalTime() const; // in seconds
     float DeltaTime() const; // in seconds
 
+    // Full precision variants.  The float TotalTime drops below millisecond precision
+    // after about 4.5 hours; these do not.
+    double       TotalTimeDouble() const; // in seconds
+    double       DeltaTimeDouble() const; // in seconds
+    std::int64_t TotalNanoseconds() const;
+    std::int64_t DeltaNanoseconds() const;
+
     void Reset(); // Call before message loop.
     void Start(); // Call when unpaused.
     void Stop();  // Call when paused.
     void Tick();  // Call every frame.
 
+    const Clock& GetClock() const { return *mClock; }
+
 private:
-    double mSecondsPerCount;
-    double mDeltaTime;
+    const Clock* mClock;
+
+    std::int64_t mDeltaTime;
 
-    __int64 mBaseTime;
-    __int64 mPausedTime;
-    __int64 mStopTime;
-    __int64 mPrevTime;
-    __int64 mCurrTime;
+    std::int64_t mBaseTime;
+    std::int64_t mPausedTime;
+    std::int64_t mStopTime;
+    std::int64_t mPrevTime;
+    std::int64_t mCurrTime;
 
     bool mStopped;
 };
 
-#endif // GAMETIMER_H
\ No newline at end of file
+#endif // GAMETIMER_H
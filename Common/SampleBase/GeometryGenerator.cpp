@@ -4,6 +4,9 @@
 #include "stdafx.h"
 
 #include "GeometryGenerator.h"
+#include "BatchMath.h"
+#include "MathHelper.h"
+#include "SimdMath.h"
 #include <algorithm>
 
 using namespace DirectX;
@@ -367,7 +370,9 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere( float radius, ui
         Subdivide( meshData );
 
     // Project vertices onto sphere and scale.
-    for ( uint32 i = 0; i < meshData.Vertices.size(); ++i )
+    size_t             vertexCount = meshData.Vertices.size();
+    std::vector<float> x( vertexCount ), y( vertexCount ), z( vertexCount );
+    for ( size_t i = 0; i < vertexCount; ++i )
     {
         // Project onto unit sphere.
         XMVECTOR n = XMVector3Normalize( XMLoadFloat3( &meshData.Vertices[i].Position ) );
@@ -378,22 +383,34 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere( float radius, ui
         XMStoreFloat3( &meshData.Vertices[i].Position, p );
         XMStoreFloat3( &meshData.Vertices[i].Normal, n );
 
-        // Derive texture coordinates from spherical coordinates.
-        float theta = atan2f( meshData.Vertices[i].Position.z, meshData.Vertices[i].Position.x );
-
-        // Put in [0, 2pi].
-        if ( theta < 0.0f )
-            theta += XM_2PI;
-
-        float phi = acosf( meshData.Vertices[i].Position.y / radius );
+        x[i] = XMVectorGetX( n );
+        y[i] = XMVectorGetY( n );
+        z[i] = XMVectorGetZ( n );
+    }
 
-        meshData.Vertices[i].TexC.x = theta / XM_2PI;
-        meshData.Vertices[i].TexC.y = phi / XM_PI;
+    // Derive texture coordinates from spherical coordinates.  The trigonometry is done
+    // in batches, reusing the coordinate arrays for the angles.  sin(phi) needs no
+    // polynomial since cos(phi) = y.
+    std::vector<float> sinTheta( vertexCount ), cosTheta( vertexCount );
+    std::vector<float>& theta  = x;
+    std::vector<float>& phi    = y;
+    std::vector<float>& sinPhi = z;
+
+    MathHelper::AngleFromXY( x.data(), z.data(), theta.data(), vertexCount );
+    SimdMath::ACos( y.data(), phi.data(), vertexCount );
+    SimdMath::SinCos( theta.data(), sinTheta.data(), cosTheta.data(), vertexCount );
+    for ( size_t i = 0; i < vertexCount; ++i )
+        sinPhi[i] = sqrtf( std::max<float>( 0.0f, 1.0f - meshData.Vertices[i].Normal.y * meshData.Vertices[i].Normal.y ) );
+
+    for ( size_t i = 0; i < vertexCount; ++i )
+    {
+        meshData.Vertices[i].TexC.x = theta[i] / XM_2PI;
+        meshData.Vertices[i].TexC.y = phi[i] / XM_PI;
 
         // Partial derivative of P with respect to theta
-        meshData.Vertices[i].TangentU.x = -radius * sinf( phi ) * sinf( theta );
+        meshData.Vertices[i].TangentU.x = -radius * sinPhi[i] * sinTheta[i];
         meshData.Vertices[i].TangentU.y = 0.0f;
-        meshData.Vertices[i].TangentU.z = +radius * sinf( phi ) * cosf( theta );
+        meshData.Vertices[i].TangentU.z = +radius * sinPhi[i] * cosTheta[i];
 
         XMVECTOR T = XMLoadFloat3( &meshData.Vertices[i].TangentU );
         XMStoreFloat3( &meshData.Vertices[i].TangentU, XMVector3Normalize( T ) );
@@ -676,3 +693,33 @@ GeometryGenerator::MeshData GeometryGenerator::CreateQuad( float x, float y, flo
 
     return meshData;
 }
+
+void GeometryGenerator::Transform( MeshData& meshData, CXMMATRIX M )
+{
+    size_t count = meshData.Vertices.size();
+    if ( count == 0 )
+        return;
+
+    // Work on structure-of-arrays copies so the batch kernels can process
+    // several vertices per instruction.
+    std::vector<float> soa( count * 3 );
+    Float3SoA          v;
+    v.X = &soa[0];
+    v.Y = &soa[count];
+    v.Z = &soa[count * 2];
+
+    const size_t stride = sizeof( Vertex );
+
+    BatchMath::Deinterleave( &meshData.Vertices[0].Position, stride, count, v );
+    BatchMath::TransformPoints( v, v, count, M );
+    BatchMath::Interleave( v, count, &meshData.Vertices[0].Position, stride );
+
+    BatchMath::Deinterleave( &meshData.Vertices[0].Normal, stride, count, v );
+    BatchMath::TransformNormals( v, v, count, M );
+    BatchMath::Interleave( v, count, &meshData.Vertices[0].Normal, stride );
+
+    BatchMath::Deinterleave( &meshData.Vertices[0].TangentU, stride, count, v );
+    BatchMath::TransformVectors( v, v, count, M );
+    BatchMath::Normalize( v, count );
+    BatchMath::Interleave( v, count, &meshData.Vertices[0].TangentU, stride );
+}
@@ -116,6 +116,12 @@ public:
     ///</summary>
     MeshData CreateQuad( float x, float y, float w, float h, float depth );
 
+    ///<summary>
+    /// Bakes the transform M into the mesh.  Positions are transformed as points, normals
+    /// by the inverse-transpose of M and tangents as directions; both are renormalized.
+    ///</summary>
+    void Transform( MeshData& meshData, DirectX::CXMMATRIX M );
+
 private:
     void   Subdivide( MeshData& meshData );
     Vertex MidPoint( const Vertex& v0, const Vertex& v1 );
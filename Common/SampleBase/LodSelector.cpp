@@ -0,0 +1,195 @@
+//***************************************************************************************
+// LodSelector.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "LodSelector.h"
+#include "Camera.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <immintrin.h>
+
+using namespace DirectX;
+
+const int LodSelector::MaxLods;
+
+namespace
+{
+    // Marks objects without a previous selection.
+    const std::uint8_t NoLod = 0xFF;
+
+    // Bisection steps when searching the threshold scale that fits the budget.
+    const int BudgetSearchSteps = 16;
+
+    // Largest threshold scale tried; beyond it every object is at its coarsest LOD anyway.
+    const float MaxThresholdScale = 65536.0f;
+
+    struct SseOps
+    {
+        typedef __m128 F;
+        static const size_t Width = 4;
+
+        static F Load( const float* p ) { return _mm_loadu_ps( p ); }
+        static void Store( float* p, F v ) { _mm_storeu_ps( p, v ); }
+        static F Set( float a ) { return _mm_set1_ps( a ); }
+        static F Sub( F a, F b ) { return _mm_sub_ps( a, b ); }
+        static F Mul( F a, F b ) { return _mm_mul_ps( a, b ); }
+        static F MulAdd( F a, F b, F c ) { return _mm_add_ps( _mm_mul_ps( a, b ), c ); }
+        static F Sqrt( F a ) { return _mm_sqrt_ps( a ); }
+        static F Max( F a, F b ) { return _mm_max_ps( a, b ); }
+    };
+
+    struct AvxOps
+    {
+        typedef __m256 F;
+        static const size_t Width = 8;
+
+        static F Load( const float* p ) { return _mm256_loadu_ps( p ); }
+        static void Store( float* p, F v ) { _mm256_storeu_ps( p, v ); }
+        static F Set( float a ) { return _mm256_set1_ps( a ); }
+        static F Sub( F a, F b ) { return _mm256_sub_ps( a, b ); }
+        static F Mul( F a, F b ) { return _mm256_mul_ps( a, b ); }
+        static F MulAdd( F a, F b, F c ) { return _mm256_fmadd_ps( a, b, c ); }
+        static F Sqrt( F a ) { return _mm256_sqrt_ps( a ); }
+        static F Max( F a, F b ) { return _mm256_max_ps( a, b ); }
+    };
+
+    // allowed = max( |center - eye| - radius, nearZ ) * errorPerDistance.  The SoA arrays
+    // are padded to a multiple of 8, and so is out.
+    template <typename Ops>
+    void ComputeAllowedError( const SphereBoundsSoA& bounds, const XMFLOAT3& eye, float nearZ, float errorPerDistance, float* out )
+    {
+        typedef typename Ops::F F;
+
+        const F eyeX    = Ops::Set( eye.x );
+        const F eyeY    = Ops::Set( eye.y );
+        const F eyeZ    = Ops::Set( eye.z );
+        const F minDist = Ops::Set( nearZ );
+        const F scale   = Ops::Set( errorPerDistance );
+
+        for ( size_t i = 0; i < bounds.GetCount(); i += Ops::Width )
+        {
+            F dx       = Ops::Sub( Ops::Load( bounds.CenterX() + i ), eyeX );
+            F dy       = Ops::Sub( Ops::Load( bounds.CenterY() + i ), eyeY );
+            F dz       = Ops::Sub( Ops::Load( bounds.CenterZ() + i ), eyeZ );
+            F distance = Ops::Sqrt( Ops::MulAdd( dx, dx, Ops::MulAdd( dy, dy, Ops::Mul( dz, dz ) ) ) );
+            distance   = Ops::Max( Ops::Sub( distance, Ops::Load( bounds.Radius() + i ) ), minDist );
+            Ops::Store( out + i, Ops::Mul( distance, scale ) );
+        }
+    }
+
+    // Number of LODs of the chain whose error is at most allowed.  Errors are sorted, so
+    // this is one more than the coarsest acceptable LOD.
+    inline int CountAcceptable( const float* errors, float allowed )
+    {
+        __m128 a    = _mm_set1_ps( allowed );
+        int    mask = _mm_movemask_ps( _mm_cmple_ps( _mm_loadu_ps( errors ), a ) ) |
+                   ( _mm_movemask_ps( _mm_cmple_ps( _mm_loadu_ps( errors + 4 ), a ) ) << 4 );
+
+        int count = 0;
+        for ( ; mask; mask &= mask - 1 )
+            ++count;
+        return count;
+    }
+} // namespace
+
+std::uint32_t LodSelector::AddChain( const Chain& chain )
+{
+    assert( chain.LodCount >= 1 && chain.LodCount <= MaxLods );
+
+    Chain padded = chain;
+    for ( int i = chain.LodCount; i < MaxLods; ++i )
+    {
+        padded.GeometricError[i] = FLT_MAX;
+        padded.TriangleCount[i]  = 0;
+    }
+
+    mChains.push_back( padded );
+    return static_cast<std::uint32_t>( mChains.size() - 1 );
+}
+
+void LodSelector::Select( const Camera& camera, float viewportHeight, const SphereBoundsSoA& bounds,
+                          const std::uint32_t* objectChains, const LodSelectionSettings& settings )
+{
+    assert( viewportHeight > 0.0f );
+
+    const size_t count = bounds.GetCount();
+
+    // An error e at distance d covers e * viewportHeight / ( 2 tan( fovY / 2 ) d ) pixels.
+    float errorPerDistance = settings.ErrorThresholdPixels * 2.0f * std::tan( 0.5f * camera.GetFovY() ) / viewportHeight;
+
+    mAllowedError.resize( ( count + 7 ) / 8 * 8 );
+    if ( CpuFeatures::HasAVX2() )
+        ComputeAllowedError<AvxOps>( bounds, camera.GetPosition3f(), camera.GetNearZ(), errorPerDistance, mAllowedError.data() );
+    else
+        ComputeAllowedError<SseOps>( bounds, camera.GetPosition3f(), camera.GetNearZ(), errorPerDistance, mAllowedError.data() );
+
+    // The last selection becomes the reference for hysteresis.
+    mPreviousLods.swap( mLods );
+    if ( mPreviousLods.size() != count )
+        mPreviousLods.assign( count, NoLod );
+    mLods.resize( count );
+
+    mThresholdScale = 1.0f;
+    mTriangleCount  = Pick( count, objectChains, 1.0f, settings.Hysteresis, mLods );
+    if ( settings.TriangleBudget == 0 || mTriangleCount <= settings.TriangleBudget )
+        return;
+
+    // Over budget: find the smallest threshold scale that fits, by doubling and then
+    // bisection.  The triangle count only decreases as the scale grows.
+    mScratchLods.resize( count );
+    float low  = 1.0f;
+    float high = 2.0f;
+    while ( high < MaxThresholdScale && Pick( count, objectChains, high, settings.Hysteresis, mScratchLods ) > settings.TriangleBudget )
+    {
+        low = high;
+        high *= 2.0f;
+    }
+    for ( int step = 0; step < BudgetSearchSteps; ++step )
+    {
+        float middle = 0.5f * ( low + high );
+        if ( Pick( count, objectChains, middle, settings.Hysteresis, mScratchLods ) > settings.TriangleBudget )
+            low = middle;
+        else
+            high = middle;
+    }
+
+    mThresholdScale = high;
+    mTriangleCount  = Pick( count, objectChains, high, settings.Hysteresis, mLods );
+}
+
+void LodSelector::Reset()
+{
+    mLods.clear();
+    mPreviousLods.clear();
+}
+
+std::uint64_t LodSelector::Pick( size_t count, const std::uint32_t* objectChains, float thresholdScale, float hysteresis,
+                                 std::vector<std::uint8_t>& lods ) const
+{
+    const float coarserScale = thresholdScale * ( 1.0f - hysteresis );
+
+    std::uint64_t triangles = 0;
+    for ( size_t i = 0; i < count; ++i )
+    {
+        const Chain& chain   = mChains[objectChains[i]];
+        const float  allowed = mAllowedError[i];
+
+        int lod      = std::max<int>( CountAcceptable( chain.GeometricError, allowed * thresholdScale ) - 1, 0 );
+        int previous = mPreviousLods[i];
+        if ( previous != NoLod && lod > previous )
+        {
+            // Only go coarser than before if the error is clearly below the threshold.
+            int strict = CountAcceptable( chain.GeometricError, allowed * coarserScale ) - 1;
+            lod        = std::max<int>( previous, strict );
+        }
+
+        lods[i] = static_cast<std::uint8_t>( lod );
+        triangles += chain.TriangleCount[lod];
+    }
+    return triangles;
+}
@@ -0,0 +1,101 @@
+//***************************************************************************************
+// LodSelector.h
+//
+// Batch level of detail selection by projected screen space error.
+//
+// Every LOD of a mesh has a geometric error: the largest distance, in object units,
+// between its surface and the full detail surface (as reported by the simplifier).  An
+// object draws the coarsest LOD whose error, projected at the object's distance from
+// the camera, stays below a threshold in pixels:
+//
+//   pixels = error * viewportHeight / ( 2 * tan( fovY / 2 ) * distance )
+//
+// with distance measured to the nearest point of the bounding sphere.  The allowed
+// error of every object is computed in one SIMD pass over the SoA bounds, and the LOD
+// errors of each object's chain are compared against it 4 at a time.
+//
+// Hysteresis: switching to a coarser LOD requires its error to be below the threshold
+// by a margin, while switching to a finer one happens as soon as the threshold is
+// exceeded, so objects near a switching distance do not flicker between two LODs.
+//
+// With a triangle budget, the threshold is raised uniformly for all objects until the
+// selected LODs fit, so detail degrades evenly across the screen.
+//***************************************************************************************
+
+#pragma once
+
+#include "FrustumCulling.h"
+#include <cstdint>
+#include <vector>
+
+class Camera;
+
+struct LodSelectionSettings
+{
+    // Largest acceptable projected error, in pixels.
+    float ErrorThresholdPixels = 1.0f;
+
+    // Relative margin below the threshold required to switch to a coarser LOD.
+    float Hysteresis = 0.2f;
+
+    // Maximum total triangle count of the selected LODs, or 0 for no budget.
+    std::uint64_t TriangleBudget = 0;
+};
+
+class LodSelector
+{
+public:
+    static const int MaxLods = 8;
+
+    // LODs of one mesh, finest first.  Errors must not decrease along the chain.
+    struct Chain
+    {
+        int           LodCount = 1;
+        float         GeometricError[MaxLods] = {};
+        std::uint32_t TriangleCount[MaxLods]  = {};
+    };
+
+    // Registers a chain and returns its index.
+    std::uint32_t AddChain( const Chain& chain );
+
+    ///<summary>
+    /// Selects a LOD for each object.  bounds holds world space bounding spheres and
+    /// objectChains[i] is the chain of object i.  The previous selection is used for
+    /// hysteresis, so objects must keep their index from one frame to the next; call
+    /// Reset when the set of objects changes.
+    ///</summary>
+    void Select( const Camera& camera, float viewportHeight, const SphereBoundsSoA& bounds,
+                 const std::uint32_t* objectChains, const LodSelectionSettings& settings = LodSelectionSettings() );
+
+    // Forgets the previous selection.
+    void Reset();
+
+    // LOD index of each object from the last Select.
+    const std::vector<std::uint8_t>& GetLods() const { return mLods; }
+
+    // Total triangles of the selected LODs.
+    std::uint64_t GetTriangleCount() const { return mTriangleCount; }
+
+    // Factor by which the budget raised the error threshold (1 without budget pressure).
+    float GetThresholdScale() const { return mThresholdScale; }
+
+private:
+    // Picks LODs for an allowed error scaled by thresholdScale into lods and returns
+    // their triangle count.
+    std::uint64_t Pick( size_t count, const std::uint32_t* objectChains, float thresholdScale, float hysteresis,
+                        std::vector<std::uint8_t>& lods ) const;
+
+private:
+    // Chain errors padded to MaxLods with FLT_MAX, so all of them can be compared at once.
+    std::vector<Chain> mChains;
+
+    // Largest geometric error each object may show at the threshold.
+    std::vector<float> mAllowedError;
+
+    std::vector<std::uint8_t> mPreviousLods;
+    std::vector<std::uint8_t> mLods;
+    std::vector<std::uint8_t> mScratchLods;
+
+    std::uint64_t mTriangleCount  = 0;
+    float         mThresholdScale = 1.0f;
+};
@@ -0,0 +1,426 @@
+//***************************************************************************************
+// LooseOctree.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "LooseOctree.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+const LooseOctree::ObjectId LooseOctree::InvalidObject;
+const std::uint32_t         LooseOctree::NoNode;
+const std::uint32_t         LooseOctree::OverflowNode;
+
+namespace
+{
+    // Deepest level supported; cell coordinates must fit in 16 bits.
+    const int MaxSupportedDepth = 16;
+
+    bool BoxOverlapsCube( const BoundingBox& box, const XMFLOAT3& center, float extent )
+    {
+        return std::fabs( box.Center.x - center.x ) <= box.Extents.x + extent &&
+               std::fabs( box.Center.y - center.y ) <= box.Extents.y + extent &&
+               std::fabs( box.Center.z - center.z ) <= box.Extents.z + extent;
+    }
+
+    bool BoxesOverlap( const BoundingBox& a, const BoundingBox& b )
+    {
+        return std::fabs( a.Center.x - b.Center.x ) <= a.Extents.x + b.Extents.x &&
+               std::fabs( a.Center.y - b.Center.y ) <= a.Extents.y + b.Extents.y &&
+               std::fabs( a.Center.z - b.Center.z ) <= a.Extents.z + b.Extents.z;
+    }
+
+    // Tests a box against the planes in planeMask, clearing the bits of the planes it
+    // is entirely inside of.  Returns false if it is entirely outside one of them.
+    bool ClassifyBox( const FrustumPlanes& frustum, const XMFLOAT3& center, const XMFLOAT3& extents, int& planeMask )
+    {
+        for ( int i = 0; i < 6; ++i )
+        {
+            if ( !( planeMask & ( 1 << i ) ) )
+                continue;
+
+            const XMFLOAT4& p = frustum.Planes[i];
+            float distance    = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+            float radius      = std::fabs( p.x ) * extents.x + std::fabs( p.y ) * extents.y + std::fabs( p.z ) * extents.z;
+            if ( distance + radius < 0.0f )
+                return false;
+            if ( distance - radius >= 0.0f )
+                planeMask &= ~( 1 << i );
+        }
+        return true;
+    }
+
+    // Slab test.  Returns the distance at which the ray enters the box (0 if it starts
+    // inside) if that is within maxDistance.
+    bool RayHitsBox( const XMFLOAT3& origin, const XMFLOAT3& invDirection, const XMFLOAT3& center, const XMFLOAT3& extents,
+                     float maxDistance, float& enter )
+    {
+        const float o[3]   = { origin.x, origin.y, origin.z };
+        const float inv[3] = { invDirection.x, invDirection.y, invDirection.z };
+        const float c[3]   = { center.x, center.y, center.z };
+        const float e[3]   = { extents.x, extents.y, extents.z };
+
+        float tMin = 0.0f;
+        float tMax = maxDistance;
+        for ( int i = 0; i < 3; ++i )
+        {
+            float t0 = ( c[i] - e[i] - o[i] ) * inv[i];
+            float t1 = ( c[i] + e[i] - o[i] ) * inv[i];
+            tMin     = std::max<float>( tMin, std::min<float>( t0, t1 ) );
+            tMax     = std::min<float>( tMax, std::max<float>( t0, t1 ) );
+        }
+
+        enter = tMin;
+        return tMin <= tMax;
+    }
+} // namespace
+
+LooseOctree::LooseOctree( const BoundingBox& worldBounds, int maxDepth, float looseness )
+    : mMaxDepth( std::min<int>( maxDepth, MaxSupportedDepth ) )
+    , mLooseness( looseness )
+{
+    assert( maxDepth >= 0 );
+    assert( looseness > 1.0f );
+
+    float halfSize = std::max<float>( worldBounds.Extents.x, std::max<float>( worldBounds.Extents.y, worldBounds.Extents.z ) );
+    mWorldSize     = 2.0f * halfSize;
+    mWorldMin      = XMFLOAT3( worldBounds.Center.x - halfSize, worldBounds.Center.y - halfSize, worldBounds.Center.z - halfSize );
+
+    Node root;
+    root.Center      = worldBounds.Center;
+    root.LooseExtent = halfSize * looseness;
+    root.Parent      = NoNode;
+    std::fill( std::begin( root.Children ), std::end( root.Children ), NoNode );
+    mNodes.push_back( root );
+}
+
+LooseOctree::ObjectId LooseOctree::Insert( const BoundingBox& bounds )
+{
+    ObjectId object;
+    if ( !mFreeObjects.empty() )
+    {
+        object = mFreeObjects.back();
+        mFreeObjects.pop_back();
+    }
+    else
+    {
+        object = static_cast<ObjectId>( mObjects.size() );
+        mObjects.push_back( ObjectRecord() );
+    }
+
+    mObjects[object].Bounds = bounds;
+    Link( object, FindNode( bounds, true ) );
+    return object;
+}
+
+void LooseOctree::Move( ObjectId object, const BoundingBox& bounds )
+{
+    assert( object < mObjects.size() && mObjects[object].Node != NoNode );
+
+    if ( FindNode( bounds, false ) == mObjects[object].Node )
+    {
+        mObjects[object].Bounds = bounds;
+        return;
+    }
+
+    // Unlink before creating the new node, since unlinking may prune its ancestors.
+    Unlink( object );
+    mObjects[object].Bounds = bounds;
+    Link( object, FindNode( bounds, true ) );
+}
+
+void LooseOctree::Remove( ObjectId object )
+{
+    assert( object < mObjects.size() && mObjects[object].Node != NoNode );
+
+    Unlink( object );
+    mObjects[object].Node = NoNode;
+    mFreeObjects.push_back( object );
+}
+
+const BoundingBox& LooseOctree::GetBounds( ObjectId object ) const
+{
+    assert( object < mObjects.size() && mObjects[object].Node != NoNode );
+    return mObjects[object].Bounds;
+}
+
+size_t LooseOctree::GetObjectCount() const
+{
+    return mObjects.size() - mFreeObjects.size();
+}
+
+void LooseOctree::Cull( const FrustumPlanes& frustum, std::vector<ObjectId>& visible ) const
+{
+    visible.clear();
+
+    for ( ObjectId object : mOverflow )
+    {
+        int planeMask = 0x3F;
+        if ( ClassifyBox( frustum, mObjects[object].Bounds.Center, mObjects[object].Bounds.Extents, planeMask ) )
+            visible.push_back( object );
+    }
+
+    if ( mNodes[0].SubtreeCount > 0 )
+        CullNode( 0, frustum, 0x3F, visible );
+}
+
+void LooseOctree::QueryBox( const BoundingBox& box, std::vector<ObjectId>& result ) const
+{
+    result.clear();
+
+    for ( ObjectId object : mOverflow )
+    {
+        if ( BoxesOverlap( box, mObjects[object].Bounds ) )
+            result.push_back( object );
+    }
+
+    std::uint32_t stack[8 * MaxSupportedDepth + 1];
+    int           top = 0;
+    stack[top++]      = 0;
+    while ( top > 0 )
+    {
+        const Node& node = mNodes[stack[--top]];
+        if ( node.SubtreeCount == 0 || !BoxOverlapsCube( box, node.Center, node.LooseExtent ) )
+            continue;
+
+        for ( ObjectId object : node.Objects )
+        {
+            if ( BoxesOverlap( box, mObjects[object].Bounds ) )
+                result.push_back( object );
+        }
+
+        for ( std::uint32_t child : node.Children )
+        {
+            if ( child != NoNode )
+                stack[top++] = child;
+        }
+    }
+}
+
+bool XM_CALLCONV LooseOctree::RayCast( FXMVECTOR origin, FXMVECTOR direction, float maxDistance, ObjectId* hitObject, float* hitDistance ) const
+{
+    XMFLOAT3 o, invDirection;
+    XMStoreFloat3( &o, origin );
+    XMStoreFloat3( &invDirection, XMVectorReciprocal( direction ) );
+
+    ObjectId best         = InvalidObject;
+    float    bestDistance = maxDistance;
+
+    auto testObjects = [&]( const std::vector<ObjectId>& objects ) {
+        for ( ObjectId object : objects )
+        {
+            float enter;
+            if ( RayHitsBox( o, invDirection, mObjects[object].Bounds.Center, mObjects[object].Bounds.Extents, bestDistance, enter ) )
+            {
+                best         = object;
+                bestDistance = enter;
+            }
+        }
+    };
+
+    testObjects( mOverflow );
+
+    // Cells are skipped once the ray enters them beyond the closest hit so far.
+    std::uint32_t stack[8 * MaxSupportedDepth + 1];
+    int           top = 0;
+    stack[top++]      = 0;
+    while ( top > 0 )
+    {
+        const Node& node = mNodes[stack[--top]];
+
+        float    enter;
+        XMFLOAT3 extents( node.LooseExtent, node.LooseExtent, node.LooseExtent );
+        if ( node.SubtreeCount == 0 || !RayHitsBox( o, invDirection, node.Center, extents, bestDistance, enter ) )
+            continue;
+
+        testObjects( node.Objects );
+
+        for ( std::uint32_t child : node.Children )
+        {
+            if ( child != NoNode )
+                stack[top++] = child;
+        }
+    }
+
+    if ( best == InvalidObject )
+        return false;
+
+    if ( hitObject )
+        *hitObject = best;
+    if ( hitDistance )
+        *hitDistance = bestDistance;
+    return true;
+}
+
+std::uint32_t LooseOctree::FindNode( const BoundingBox& bounds, bool create )
+{
+    // Deepest level whose loose cells still hold the object wherever its center lies
+    // in the cell: extent <= (looseness - 1) * cell half size.
+    float maxExtent = std::max<float>( bounds.Extents.x, std::max<float>( bounds.Extents.y, bounds.Extents.z ) );
+    float cellHalf  = 0.5f * mWorldSize;
+    int   depth     = 0;
+    while ( depth < mMaxDepth && maxExtent <= ( mLooseness - 1.0f ) * 0.5f * cellHalf )
+    {
+        cellHalf *= 0.5f;
+        ++depth;
+    }
+
+    // Cell containing the center, clamped to the world.
+    int   cells    = 1 << depth;
+    float cellSize = 2.0f * cellHalf;
+    auto  cellOf   = [&]( float p, float min ) {
+        return std::min<int>( std::max<int>( static_cast<int>( std::floor( ( p - min ) / cellSize ) ), 0 ), cells - 1 );
+    };
+    int ix = cellOf( bounds.Center.x, mWorldMin.x );
+    int iy = cellOf( bounds.Center.y, mWorldMin.y );
+    int iz = cellOf( bounds.Center.z, mWorldMin.z );
+
+    // Objects outside the world may not fit the clamped cell.
+    float    looseExtent = cellHalf * mLooseness;
+    XMFLOAT3 cellCenter( mWorldMin.x + ( ix + 0.5f ) * cellSize, mWorldMin.y + ( iy + 0.5f ) * cellSize, mWorldMin.z + ( iz + 0.5f ) * cellSize );
+    if ( std::fabs( bounds.Center.x - cellCenter.x ) + bounds.Extents.x > looseExtent ||
+         std::fabs( bounds.Center.y - cellCenter.y ) + bounds.Extents.y > looseExtent ||
+         std::fabs( bounds.Center.z - cellCenter.z ) + bounds.Extents.z > looseExtent )
+    {
+        return OverflowNode;
+    }
+
+    std::uint32_t node = 0;
+    for ( int level = depth - 1; level >= 0; --level )
+    {
+        int child = ( ( ix >> level ) & 1 ) | ( ( ( iy >> level ) & 1 ) << 1 ) | ( ( ( iz >> level ) & 1 ) << 2 );
+        if ( mNodes[node].Children[child] == NoNode )
+        {
+            if ( !create )
+                return NoNode;
+
+            std::uint32_t newNode        = AllocateNode( node, child );
+            mNodes[node].Children[child] = newNode;
+        }
+        node = mNodes[node].Children[child];
+    }
+    return node;
+}
+
+std::uint32_t LooseOctree::AllocateNode( std::uint32_t parent, int child )
+{
+    // Copy what is needed from the parent before mNodes can reallocate.
+    float    childHalf = 0.5f * mNodes[parent].LooseExtent / mLooseness;
+    XMFLOAT3 center    = mNodes[parent].Center;
+    center.x += ( child & 1 ) ? childHalf : -childHalf;
+    center.y += ( child & 2 ) ? childHalf : -childHalf;
+    center.z += ( child & 4 ) ? childHalf : -childHalf;
+
+    std::uint32_t index;
+    if ( !mFreeNodes.empty() )
+    {
+        index = mFreeNodes.back();
+        mFreeNodes.pop_back();
+    }
+    else
+    {
+        index = static_cast<std::uint32_t>( mNodes.size() );
+        mNodes.push_back( Node() );
+    }
+
+    Node& node        = mNodes[index];
+    node.Center       = center;
+    node.LooseExtent  = childHalf * mLooseness;
+    node.Parent       = parent;
+    node.SubtreeCount = 0;
+    node.Objects.clear();
+    std::fill( std::begin( node.Children ), std::end( node.Children ), NoNode );
+    return index;
+}
+
+void LooseOctree::Link( ObjectId object, std::uint32_t node )
+{
+    ObjectRecord& record = mObjects[object];
+    record.Node          = node;
+
+    if ( node == OverflowNode )
+    {
+        record.IndexInNode = static_cast<std::uint32_t>( mOverflow.size() );
+        mOverflow.push_back( object );
+        return;
+    }
+
+    record.IndexInNode = static_cast<std::uint32_t>( mNodes[node].Objects.size() );
+    mNodes[node].Objects.push_back( object );
+
+    for ( std::uint32_t n = node; n != NoNode; n = mNodes[n].Parent )
+        ++mNodes[n].SubtreeCount;
+}
+
+void LooseOctree::Unlink( ObjectId object )
+{
+    const ObjectRecord& record = mObjects[object];
+
+    std::vector<ObjectId>& objects = record.Node == OverflowNode ? mOverflow : mNodes[record.Node].Objects;
+    ObjectId               moved   = objects.back();
+    objects[record.IndexInNode]    = moved;
+    mObjects[moved].IndexInNode    = record.IndexInNode;
+    objects.pop_back();
+
+    if ( record.Node == OverflowNode )
+        return;
+
+    // Decrement the counts up to the root, freeing the nodes that become empty.
+    std::uint32_t n = record.Node;
+    while ( n != NoNode )
+    {
+        std::uint32_t parent = mNodes[n].Parent;
+        if ( --mNodes[n].SubtreeCount == 0 && parent != NoNode )
+        {
+            std::uint32_t* children = mNodes[parent].Children;
+            *std::find( children, children + 8, n ) = NoNode;
+            mFreeNodes.push_back( n );
+        }
+        n = parent;
+    }
+}
+
+void LooseOctree::CullNode( std::uint32_t nodeIndex, const FrustumPlanes& frustum, int planeMask, std::vector<ObjectId>& visible ) const
+{
+    const Node& node = mNodes[nodeIndex];
+
+    XMFLOAT3 extents( node.LooseExtent, node.LooseExtent, node.LooseExtent );
+    if ( !ClassifyBox( frustum, node.Center, extents, planeMask ) )
+        return;
+
+    // Every object of the subtree lies inside the loose cell.
+    if ( planeMask == 0 )
+    {
+        AppendSubtree( nodeIndex, visible );
+        return;
+    }
+
+    for ( ObjectId object : node.Objects )
+    {
+        int objectMask = planeMask;
+        if ( ClassifyBox( frustum, mObjects[object].Bounds.Center, mObjects[object].Bounds.Extents, objectMask ) )
+            visible.push_back( object );
+    }
+
+    for ( std::uint32_t child : node.Children )
+    {
+        if ( child != NoNode )
+            CullNode( child, frustum, planeMask, visible );
+    }
+}
+
+void LooseOctree::AppendSubtree( std::uint32_t nodeIndex, std::vector<ObjectId>& result ) const
+{
+    const Node& node = mNodes[nodeIndex];
+    result.insert( result.end(), node.Objects.begin(), node.Objects.end() );
+
+    for ( std::uint32_t child : node.Children )
+    {
+        if ( child != NoNode )
+            AppendSubtree( child, result );
+    }
+}
@@ -0,0 +1,109 @@
+//***************************************************************************************
+// LooseOctree.h
+//
+// Loose octree over object bounding boxes for hierarchical culling and spatial queries.
+//
+// The cells of a loose octree are enlarged by a looseness factor (typically 2), so an
+// object is stored at the depth where its size fits the cell size, in the cell that
+// contains its center.  Both are computed directly from the object's bounds, which
+// makes Insert, Move and Remove O(depth) with no rebalancing; a Move within the same
+// cell only updates the stored bounds.
+//
+// Frustum culling walks the tree, skipping empty subtrees and cells outside the
+// frustum, and accepts cells entirely inside it without testing their objects.  Planes
+// that a cell is entirely inside of are not tested again for its descendants.
+//
+// Objects that do not fit in the world bounds are kept in a separate list that every
+// query tests individually, so they are never lost, merely slower.
+//***************************************************************************************
+
+#pragma once
+
+#include "FrustumCulling.h"
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <vector>
+
+class LooseOctree
+{
+public:
+    using ObjectId = std::uint32_t;
+
+    static const ObjectId InvalidObject = 0xFFFFFFFF;
+
+    // worldBounds should enclose the scene; the root cell is the cube around it.  Pick
+    // maxDepth so that the smallest cells still hold several objects: deeper trees cost
+    // more node visits than they save in object tests.
+    explicit LooseOctree( const DirectX::BoundingBox& worldBounds, int maxDepth = 6, float looseness = 2.0f );
+
+    ObjectId Insert( const DirectX::BoundingBox& bounds );
+    void     Move( ObjectId object, const DirectX::BoundingBox& bounds );
+    void     Remove( ObjectId object );
+
+    const DirectX::BoundingBox& GetBounds( ObjectId object ) const;
+    size_t                      GetObjectCount() const;
+
+    // Replaces visible with the objects that intersect the frustum, in no particular order.
+    void Cull( const FrustumPlanes& frustum, std::vector<ObjectId>& visible ) const;
+
+    // Replaces result with the objects whose bounds intersect box.
+    void QueryBox( const DirectX::BoundingBox& box, std::vector<ObjectId>& result ) const;
+
+    // Finds the object whose bounds the ray enters first within maxDistance.  direction
+    // must be normalized.  Returns false if there is none.
+    bool XM_CALLCONV RayCast( DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDistance,
+                              ObjectId* hitObject, float* hitDistance ) const;
+
+private:
+    struct Node
+    {
+        DirectX::XMFLOAT3 Center;
+        float             LooseExtent; // half size of the loose cell
+
+        std::uint32_t Parent;
+        std::uint32_t Children[8];
+
+        // Objects in this node and all its descendants.
+        std::uint32_t SubtreeCount = 0;
+
+        std::vector<ObjectId> Objects;
+    };
+
+    struct ObjectRecord
+    {
+        DirectX::BoundingBox Bounds;
+        std::uint32_t        Node;
+        std::uint32_t        IndexInNode;
+    };
+
+    // Node that should store bounds, or OverflowNode.  With create set, missing nodes on
+    // the way are created; otherwise NoNode is returned if the node does not exist.
+    std::uint32_t FindNode( const DirectX::BoundingBox& bounds, bool create );
+    std::uint32_t AllocateNode( std::uint32_t parent, int child );
+
+    void Link( ObjectId object, std::uint32_t node );
+    void Unlink( ObjectId object );
+
+    void CullNode( std::uint32_t node, const FrustumPlanes& frustum, int planeMask, std::vector<ObjectId>& visible ) const;
+    void AppendSubtree( std::uint32_t node, std::vector<ObjectId>& result ) const;
+
+private:
+    static const std::uint32_t NoNode       = 0xFFFFFFFF;
+    static const std::uint32_t OverflowNode = 0xFFFFFFFE;
+
+    DirectX::XMFLOAT3 mWorldMin;
+    float             mWorldSize;
+    int               mMaxDepth;
+    float             mLooseness;
+
+    // mNodes[0] is the root.
+    std::vector<Node>          mNodes;
+    std::vector<std::uint32_t> mFreeNodes;
+
+    // Indexed by ObjectId; Node is NoNode for free ids.
+    std::vector<ObjectRecord> mObjects;
+    std::vector<ObjectId>     mFreeObjects;
+
+    // Objects outside the world bounds.
+    std::vector<ObjectId> mOverflow;
+};
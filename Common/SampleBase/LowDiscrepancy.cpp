@@ -0,0 +1,386 @@
+//***************************************************************************************
+// LowDiscrepancy.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "LowDiscrepancy.h"
+#include "Random.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    const std::uint32_t Primes[LowDiscrepancy::MaxHaltonDimensions] = {
+        2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53 };
+
+    // Largest float below 1.
+    const float OneMinusEpsilon = 0.99999994f;
+
+    std::uint32_t ReverseBits( std::uint32_t x )
+    {
+        x = ( x << 16 ) | ( x >> 16 );
+        x = ( ( x & 0x00FF00FFu ) << 8 ) | ( ( x & 0xFF00FF00u ) >> 8 );
+        x = ( ( x & 0x0F0F0F0Fu ) << 4 ) | ( ( x & 0xF0F0F0F0u ) >> 4 );
+        x = ( ( x & 0x33333333u ) << 2 ) | ( ( x & 0xCCCCCCCCu ) >> 2 );
+        x = ( ( x & 0x55555555u ) << 1 ) | ( ( x & 0xAAAAAAAAu ) >> 1 );
+        return x;
+    }
+
+    // 32-bit fixed point fraction to float in [0, 1).  Only the top 24 bits are representable.
+    inline float FixedToFloat( std::uint32_t x )
+    {
+        return (float)( x >> 8 ) * ( 1.0f / 16777216.0f );
+    }
+
+    // Fractional part of v as 0.32 fixed point.  A fraction that rounds up to exactly 1
+    // wraps to 0 in the final cast.
+    inline std::uint32_t FractionToFixed( float v )
+    {
+        double fraction = v - std::floor( (double)v );
+        return (std::uint32_t)(std::uint64_t)( fraction * 4294967296.0 );
+    }
+
+    //
+    // Sobol direction numbers.  Dimension 0 is the van der Corput sequence; dimensions
+    // 1-3 use the primitive polynomials and initial numbers of Joe & Kuo (new-joe-kuo-6.21201).
+    //
+
+    struct SobolInit
+    {
+        std::uint32_t S;
+        std::uint32_t A;
+        std::uint32_t M[3];
+    };
+
+    const SobolInit SobolInits[LowDiscrepancy::MaxSobolDimensions - 1] = {
+        { 1, 0, { 1, 0, 0 } },
+        { 2, 1, { 1, 3, 0 } },
+        { 3, 1, { 1, 3, 1 } },
+    };
+
+    struct SobolMatrices
+    {
+        std::uint32_t V[LowDiscrepancy::MaxSobolDimensions][32];
+
+        SobolMatrices()
+        {
+            for ( std::uint32_t k = 0; k < 32; ++k )
+                V[0][k] = 1u << ( 31 - k );
+
+            for ( std::uint32_t d = 1; d < LowDiscrepancy::MaxSobolDimensions; ++d )
+            {
+                const SobolInit& init = SobolInits[d - 1];
+                std::uint32_t*   v    = V[d];
+
+                for ( std::uint32_t k = 0; k < init.S; ++k )
+                    v[k] = init.M[k] << ( 31 - k );
+
+                for ( std::uint32_t k = init.S; k < 32; ++k )
+                {
+                    v[k] = v[k - init.S] ^ ( v[k - init.S] >> init.S );
+                    for ( std::uint32_t l = 1; l < init.S; ++l )
+                    {
+                        if ( ( init.A >> ( init.S - 1 - l ) ) & 1 )
+                            v[k] ^= v[k - l];
+                    }
+                }
+            }
+        }
+    };
+
+    const SobolMatrices& GetSobolMatrices()
+    {
+        static const SobolMatrices matrices;
+        return matrices;
+    }
+
+    std::uint32_t SobolBits( std::uint32_t dimension, std::uint32_t index )
+    {
+        const std::uint32_t* v      = GetSobolMatrices().V[dimension];
+        std::uint32_t        result = 0;
+        for ( std::uint32_t k = 0; index != 0; index >>= 1, ++k )
+        {
+            if ( index & 1 )
+                result ^= v[k];
+        }
+        return result;
+    }
+
+    //
+    // Hash-based Owen scrambling, from Burley, "Practical Hash-based Owen Scrambling", JCGT 2020.
+    //
+
+    std::uint32_t LaineKarrasPermutation( std::uint32_t x, std::uint32_t seed )
+    {
+        x += seed;
+        x ^= x * 0x6c50b47cu;
+        x ^= x * 0xb82f1e52u;
+        x ^= x * 0xc7afe638u;
+        x ^= x * 0x8d22f6e6u;
+        return x;
+    }
+
+    std::uint32_t NestedUniformScramble( std::uint32_t x, std::uint32_t seed )
+    {
+        return ReverseBits( LaineKarrasPermutation( ReverseBits( x ), seed ) );
+    }
+
+    std::uint32_t HashU32( std::uint32_t x )
+    {
+        x ^= x >> 17;
+        x *= 0xed5ad4bbu;
+        x ^= x >> 11;
+        x *= 0xac4c1b51u;
+        x ^= x >> 15;
+        x *= 0x31848babu;
+        x ^= x >> 14;
+        return x;
+    }
+
+    std::uint32_t HashCombine( std::uint32_t seed, std::uint32_t v )
+    {
+        return seed ^ ( v + ( seed << 6 ) + ( seed >> 2 ) );
+    }
+} // namespace
+
+float LowDiscrepancy::RadicalInverse( std::uint32_t base, std::uint32_t index )
+{
+    if ( base == 2 )
+        return FixedToFloat( ReverseBits( index ) );
+
+    const double  invBase  = 1.0 / base;
+    double        invBaseN = 1.0;
+    std::uint64_t reversed = 0;
+    while ( index != 0 )
+    {
+        std::uint32_t next  = index / base;
+        std::uint32_t digit = index - next * base;
+        reversed            = reversed * base + digit;
+        invBaseN *= invBase;
+        index = next;
+    }
+
+    return std::min<float>( (float)( reversed * invBaseN ), OneMinusEpsilon );
+}
+
+float LowDiscrepancy::Halton( std::uint32_t dimension, std::uint32_t index )
+{
+    assert( dimension < MaxHaltonDimensions );
+    return RadicalInverse( Primes[dimension], index );
+}
+
+float LowDiscrepancy::Sobol( std::uint32_t dimension, std::uint32_t index )
+{
+    assert( dimension < MaxSobolDimensions );
+    return FixedToFloat( SobolBits( dimension, index ) );
+}
+
+float LowDiscrepancy::OwenScrambledSobol( std::uint32_t dimension, std::uint32_t index, std::uint32_t seed )
+{
+    assert( dimension < MaxSobolDimensions );
+
+    // Shuffle the point order too, so that prefixes of different seeds are decorrelated.
+    std::uint32_t shuffled = NestedUniformScramble( index, HashU32( seed ) );
+    std::uint32_t bits     = SobolBits( dimension, shuffled );
+
+    return FixedToFloat( NestedUniformScramble( bits, HashCombine( seed, HashU32( dimension ) ) ) );
+}
+
+XMFLOAT2 LowDiscrepancy::R2( std::uint32_t index, XMFLOAT2 offset )
+{
+    // 1/g and 1/g^2 for the plastic number g, as 0.32 fixed point so the
+    // recurrence stays exact for every 32-bit index.
+    const std::uint32_t Alpha1 = 3242174889u;
+    const std::uint32_t Alpha2 = 2447445414u;
+
+    std::uint32_t x = FractionToFixed( offset.x ) + index * Alpha1;
+    std::uint32_t y = FractionToFixed( offset.y ) + index * Alpha2;
+
+    return XMFLOAT2( FixedToFloat( x ), FixedToFloat( y ) );
+}
+
+void LowDiscrepancy::FillHalton2D( XMFLOAT2* out, size_t count, std::uint32_t first )
+{
+    for ( size_t i = 0; i < count; ++i )
+    {
+        std::uint32_t index = first + (std::uint32_t)i;
+        out[i]              = XMFLOAT2( RadicalInverse( 2, index ), RadicalInverse( 3, index ) );
+    }
+}
+
+std::vector<float> LowDiscrepancy::GenerateBlueNoiseTile( std::uint32_t size, std::uint64_t seed, float sigma )
+{
+    assert( size > 0 );
+
+    const std::uint32_t count = size * size;
+
+    // Gaussian energy filter over toroidal distances so the tile wraps seamlessly.
+    std::vector<float> filter( count );
+    for ( std::uint32_t y = 0; y < size; ++y )
+    {
+        for ( std::uint32_t x = 0; x < size; ++x )
+        {
+            float dx              = (float)std::min<std::uint32_t>( x, size - x );
+            float dy              = (float)std::min<std::uint32_t>( y, size - y );
+            filter[y * size + x] = expf( -( dx * dx + dy * dy ) / ( 2.0f * sigma * sigma ) );
+        }
+    }
+
+    auto splat = [&]( std::vector<float>& energy, std::uint32_t p, float sign ) {
+        std::uint32_t px = p % size;
+        std::uint32_t py = p / size;
+        for ( std::uint32_t y = 0; y < size; ++y )
+        {
+            std::uint32_t fy = ( y + size - py ) % size;
+            for ( std::uint32_t x = 0; x < size; ++x )
+            {
+                std::uint32_t fx = ( x + size - px ) % size;
+                energy[y * size + x] += sign * filter[fy * size + fx];
+            }
+        }
+    };
+
+    // The set pixel in the densest region.
+    auto tightestCluster = [&]( const std::vector<std::uint8_t>& pattern, const std::vector<float>& energy ) {
+        std::uint32_t best = 0;
+        float         e    = -FLT_MAX;
+        for ( std::uint32_t i = 0; i < count; ++i )
+        {
+            if ( pattern[i] && energy[i] > e )
+            {
+                e    = energy[i];
+                best = i;
+            }
+        }
+        return best;
+    };
+
+    // The empty pixel in the sparsest region.
+    auto largestVoid = [&]( const std::vector<std::uint8_t>& pattern, const std::vector<float>& energy ) {
+        std::uint32_t best = 0;
+        float         e    = FLT_MAX;
+        for ( std::uint32_t i = 0; i < count; ++i )
+        {
+            if ( !pattern[i] && energy[i] < e )
+            {
+                e    = energy[i];
+                best = i;
+            }
+        }
+        return best;
+    };
+
+    // Initial binary pattern: about 10% of the pixels set at random, then relaxed by
+    // moving the tightest cluster into the largest void until that is a no-op.
+    std::vector<std::uint8_t> pattern( count, 0 );
+    std::vector<float>        energy( count, 0.0f );
+
+    std::vector<std::uint32_t> order( count );
+    for ( std::uint32_t i = 0; i < count; ++i )
+        order[i] = i;
+
+    RandomEngine rng( seed );
+    for ( std::uint32_t i = count - 1; i > 0; --i )
+        std::swap( order[i], order[rng.NextInt( 0, (int)i )] );
+
+    const std::uint32_t initialOnes = std::max<std::uint32_t>( 1u, count / 10 );
+    for ( std::uint32_t i = 0; i < initialOnes; ++i )
+    {
+        pattern[order[i]] = 1;
+        splat( energy, order[i], 1.0f );
+    }
+
+    for ( std::uint32_t iteration = 0; iteration < count; ++iteration )
+    {
+        std::uint32_t cluster = tightestCluster( pattern, energy );
+        pattern[cluster]      = 0;
+        splat( energy, cluster, -1.0f );
+
+        std::uint32_t hole = largestVoid( pattern, energy );
+        pattern[hole]      = 1;
+        splat( energy, hole, 1.0f );
+
+        if ( hole == cluster )
+            break;
+    }
+
+    std::vector<std::uint32_t> rank( count, 0 );
+
+    // Phase 1: rank the initial pattern by repeatedly removing the tightest cluster.
+    {
+        std::vector<std::uint8_t> p = pattern;
+        std::vector<float>        e = energy;
+        for ( std::uint32_t r = initialOnes; r-- > 0; )
+        {
+            std::uint32_t cluster = tightestCluster( p, e );
+            p[cluster]            = 0;
+            splat( e, cluster, -1.0f );
+            rank[cluster] = r;
+        }
+    }
+
+    // Phase 2: fill the remaining pixels, always into the largest void.
+    for ( std::uint32_t r = initialOnes; r < count; ++r )
+    {
+        std::uint32_t hole = largestVoid( pattern, energy );
+        pattern[hole]      = 1;
+        splat( energy, hole, 1.0f );
+        rank[hole] = r;
+    }
+
+    std::vector<float> thresholds( count );
+    for ( std::uint32_t i = 0; i < count; ++i )
+        thresholds[i] = ( rank[i] + 0.5f ) / count;
+
+    return thresholds;
+}
+
+LowDiscrepancy::ScrambledHalton::ScrambledHalton( std::uint32_t dimensions, std::uint64_t seed )
+{
+    assert( dimensions <= MaxHaltonDimensions );
+
+    RandomEngine rng( seed );
+
+    mOffsets.resize( dimensions );
+    for ( std::uint32_t d = 0; d < dimensions; ++d )
+    {
+        std::uint32_t base = Primes[d];
+        mOffsets[d]        = (std::uint32_t)mPermutations.size();
+
+        for ( std::uint32_t i = 0; i < base; ++i )
+            mPermutations.push_back( (std::uint16_t)i );
+
+        std::uint16_t* perm = &mPermutations[mOffsets[d]];
+        for ( std::uint32_t i = base - 1; i > 0; --i )
+            std::swap( perm[i], perm[rng.NextInt( 0, (int)i )] );
+    }
+}
+
+float LowDiscrepancy::ScrambledHalton::Sample( std::uint32_t dimension, std::uint32_t index ) const
+{
+    assert( dimension < mOffsets.size() );
+
+    const std::uint32_t  base = Primes[dimension];
+    const std::uint16_t* perm = &mPermutations[mOffsets[dimension]];
+
+    // Permute every digit, including the infinitely many leading zeros, until
+    // the remaining digits no longer change the float result.
+    const double  invBase  = 1.0 / base;
+    double        invBaseN = 1.0;
+    std::uint64_t reversed = 0;
+    while ( invBaseN * base > 1.0 / 16777216.0 )
+    {
+        std::uint32_t next  = index / base;
+        std::uint32_t digit = index - next * base;
+        reversed            = reversed * base + perm[digit];
+        invBaseN *= invBase;
+        index = next;
+    }
+
+    return std::min<float>( (float)( reversed * invBaseN ), OneMinusEpsilon );
+}
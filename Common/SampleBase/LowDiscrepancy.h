@@ -0,0 +1,69 @@
+//***************************************************************************************
+// LowDiscrepancy.h
+//
+// Low-discrepancy sequences and blue-noise tiles for sampling.
+//
+// Compared to independent random numbers these cover the sampling domain much more
+// evenly, so a given error is reached with fewer samples:
+//   -Halton: radical inverses in successive prime bases, optionally scrambled with
+//    per-base random digit permutations to break the correlation between dimensions.
+//   -Sobol: base-2 sequence (first 4 dimensions), optionally Owen scrambled using the
+//    hash-based nested uniform scramble of Burley 2020.
+//   -R2: the additive recurrence based on the plastic number (Roberts 2018).
+//   -Blue noise: void-and-cluster threshold tiles (Ulichney 1993), generated offline
+//    and tiled over the screen, e.g. to rotate per-pixel AO kernels.
+//***************************************************************************************
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+class LowDiscrepancy
+{
+public:
+    static const std::uint32_t MaxHaltonDimensions = 16;
+    static const std::uint32_t MaxSobolDimensions  = 4;
+
+    // Radical inverse of index in the given base, in [0, 1).
+    static float RadicalInverse( std::uint32_t base, std::uint32_t index );
+
+    // Component dimension of the index-th Halton point (dimension d uses the d-th prime).
+    static float Halton( std::uint32_t dimension, std::uint32_t index );
+
+    // Component dimension of the index-th Sobol point.
+    static float Sobol( std::uint32_t dimension, std::uint32_t index );
+
+    // Owen scrambled Sobol.  Different seeds give statistically independent
+    // point sets that keep the stratification of the unscrambled sequence.
+    static float OwenScrambledSobol( std::uint32_t dimension, std::uint32_t index, std::uint32_t seed );
+
+    // The index-th point of the 2D R2 sequence, starting from offset.  The sequence
+    // lives on the unit torus, so only the fractional part of offset matters.
+    static DirectX::XMFLOAT2 R2( std::uint32_t index, DirectX::XMFLOAT2 offset = DirectX::XMFLOAT2( 0.5f, 0.5f ) );
+
+    // Fills count 2D points (Halton bases 2 and 3) starting at index first.
+    static void FillHalton2D( DirectX::XMFLOAT2* out, size_t count, std::uint32_t first = 0 );
+
+    ///<summary>
+    /// Generates a size x size tileable blue-noise threshold map with the void-and-cluster
+    /// method.  Every value (rank + 0.5) / (size*size) appears exactly once, so thresholding
+    /// the tile at any level gives an evenly spread point set.  This costs O(size^4) and is
+    /// meant to be run offline or at load time; 64x64 takes well under a second.
+    ///</summary>
+    static std::vector<float> GenerateBlueNoiseTile( std::uint32_t size, std::uint64_t seed, float sigma = 1.5f );
+
+    // Halton sequence whose digits are scrambled with a random permutation per base.
+    class ScrambledHalton
+    {
+    public:
+        ScrambledHalton( std::uint32_t dimensions, std::uint64_t seed );
+
+        float Sample( std::uint32_t dimension, std::uint32_t index ) const;
+
+    private:
+        std::vector<std::uint16_t> mPermutations;
+        std::vector<std::uint32_t> mOffsets;
+    };
+};
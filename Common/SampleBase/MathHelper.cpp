@@ -5,6 +5,8 @@
 #include "stdafx.h"
 
 #include "MathHelper.h"
+#include "SimdMath.h"
+#include <algorithm>
 #include <float.h>
 #include <cmath>
 
@@ -35,50 +37,210 @@ float MathHelper::AngleFromXY( float x, float y )
     return theta;
 }
 
-XMVECTOR MathHelper::RandUnitVec3()
+void MathHelper::AngleFromXY( const float* x, const float* y, float* theta, size_t count )
 {
-    XMVECTOR One  = XMVectorSet( 1.0f, 1.0f, 1.0f, 1.0f );
-    XMVECTOR Zero = XMVectorZero();
+    SimdMath::ATan2( y, x, theta, count ); // in [-pi, pi]
 
-    // Keep trying until we get a point on/in the hemisphere.
-    while ( true )
+    for ( size_t i = 0; i < count; ++i )
     {
-        // Generate random point in the cube [-1,1]^3.
-        XMVECTOR v = XMVectorSet( MathHelper::RandF( -1.0f, 1.0f ), MathHelper::RandF( -1.0f, 1.0f ), MathHelper::RandF( -1.0f, 1.0f ), 0.0f );
+        if ( theta[i] < 0.0f )
+            theta[i] += 2.0f * Pi; // in [0, 2*pi).
+    }
+}
 
-        // Ignore points outside the unit sphere in order to get an even distribution
-        // over the unit sphere.  Otherwise points will clump more on the sphere near
-        // the corners of the cube.
+void MathHelper::SphericalToCartesian( float radius, const float* theta, const float* phi, XMFLOAT3* out, size_t count )
+{
+    const size_t BlockSize = 64;
 
-        if ( XMVector3Greater( XMVector3LengthSq( v ), One ) )
-            continue;
+    float sinTheta[BlockSize], cosTheta[BlockSize];
+    float sinPhi[BlockSize], cosPhi[BlockSize];
 
-        return XMVector3Normalize( v );
+    for ( size_t begin = 0; begin < count; begin += BlockSize )
+    {
+        size_t n = std::min<size_t>( BlockSize, count - begin );
+        SimdMath::SinCos( theta + begin, sinTheta, cosTheta, n );
+        SimdMath::SinCos( phi + begin, sinPhi, cosPhi, n );
+
+        for ( size_t i = 0; i < n; ++i )
+        {
+            out[begin + i].x = radius * sinPhi[i] * cosTheta[i];
+            out[begin + i].y = radius * cosPhi[i];
+            out[begin + i].z = radius * sinPhi[i] * sinTheta[i];
+        }
     }
 }
 
-XMVECTOR MathHelper::RandHemisphereUnitVec3( XMVECTOR n )
+namespace
 {
-    XMVECTOR One  = XMVectorSet( 1.0f, 1.0f, 1.0f, 1.0f );
-    XMVECTOR Zero = XMVectorZero();
+    // Maps two uniform numbers in [0, 1) to a uniformly distributed unit vector.
+    XMVECTOR UniformSphere( float u1, float u2 )
+    {
+        float z   = 1.0f - 2.0f * u1;
+        float r   = sqrtf( MathHelper::Max( 0.0f, 1.0f - z * z ) );
+        float phi = 2.0f * MathHelper::Pi * u2;
+
+        return XMVectorSet( r * cosf( phi ), r * sinf( phi ), z, 0.0f );
+    }
 
-    // Keep trying until we get a point on/in the hemisphere.
-    while ( true )
+    enum class DirectionDistribution
     {
-        // Generate random point in the cube [-1,1]^3.
-        XMVECTOR v = XMVectorSet( MathHelper::RandF( -1.0f, 1.0f ), MathHelper::RandF( -1.0f, 1.0f ), MathHelper::RandF( -1.0f, 1.0f ), 0.0f );
+        Cone,   // uniform in solid angle, z in [cosThetaMax, 1]
+        Cosine, // cosine-weighted hemisphere
+    };
 
-        // Ignore points outside the unit sphere in order to get an even distribution
-        // over the unit sphere.  Otherwise points will clump more on the sphere near
-        // the corners of the cube.
+    void BuildOrthonormalBasis( FXMVECTOR n, XMVECTOR& t, XMVECTOR& b )
+    {
+        // Branchless basis from Duff et al., "Building an Orthonormal Basis, Revisited".
+        XMFLOAT3 v;
+        XMStoreFloat3( &v, n );
 
-        if ( XMVector3Greater( XMVector3LengthSq( v ), One ) )
-            continue;
+        float sign = v.z >= 0.0f ? 1.0f : -1.0f;
+        float a    = -1.0f / ( sign + v.z );
+        float c    = v.x * v.y * a;
 
-        // Ignore points in the bottom hemisphere.
-        if ( XMVector3Less( XMVector3Dot( n, v ), Zero ) )
-            continue;
+        t = XMVectorSet( 1.0f + sign * v.x * v.x * a, sign * c, -sign * v.x, 0.0f );
+        b = XMVectorSet( c, sign + v.y * v.y * a, -v.y, 0.0f );
+    }
 
-        return XMVector3Normalize( v );
+    void SampleDirections(
+        XMFLOAT3*             out,
+        size_t                count,
+        FXMVECTOR             axis,
+        DirectionDistribution distribution,
+        float                 cosThetaMax,
+        RandomEngine&         rng )
+    {
+        XMVECTOR t, b;
+        BuildOrthonormalBasis( axis, t, b );
+
+        XMFLOAT3 tf, bf, nf;
+        XMStoreFloat3( &tf, t );
+        XMStoreFloat3( &bf, b );
+        XMStoreFloat3( &nf, axis );
+
+        const XMVECTOR zero    = XMVectorZero();
+        const XMVECTOR one     = XMVectorSplatOne();
+        const XMVECTOR twoPi   = XMVectorReplicate( XM_2PI );
+        const XMVECTOR zExtent = XMVectorReplicate( 1.0f - cosThetaMax );
+
+        // Random numbers are drawn in blocks: u1 in the first half, u2 in the second.
+        const size_t BlockSize = 64;
+        alignas( 16 ) float u[2 * BlockSize];
+
+        for ( size_t base = 0; base < count; base += BlockSize )
+        {
+            size_t n       = MathHelper::Min( BlockSize, count - base );
+            size_t rounded = ( n + 3 ) & ~size_t( 3 );
+            rng.FillFloats( u, 2 * BlockSize );
+
+            for ( size_t i = 0; i < rounded; i += 4 )
+            {
+                XMVECTOR u1 = XMLoadFloat4A( reinterpret_cast<const XMFLOAT4A*>( &u[i] ) );
+                XMVECTOR u2 = XMLoadFloat4A( reinterpret_cast<const XMFLOAT4A*>( &u[BlockSize + i] ) );
+
+                XMVECTOR z, r;
+                if ( distribution == DirectionDistribution::Cone )
+                {
+                    z = XMVectorNegativeMultiplySubtract( u1, zExtent, one ); // 1 - u1 * (1 - cosThetaMax)
+                    r = XMVectorSqrt( XMVectorMax( zero, XMVectorNegativeMultiplySubtract( z, z, one ) ) );
+                }
+                else
+                {
+                    r = XMVectorSqrt( u1 );
+                    z = XMVectorSqrt( XMVectorMax( zero, XMVectorSubtract( one, u1 ) ) );
+                }
+
+                XMVECTOR sinPhi, cosPhi;
+                XMVectorSinCos( &sinPhi, &cosPhi, XMVectorMultiply( u2, twoPi ) );
+
+                XMVECTOR x = XMVectorMultiply( r, cosPhi );
+                XMVECTOR y = XMVectorMultiply( r, sinPhi );
+
+                // Rotate from the local frame: w = x*t + y*b + z*n, one component at a time.
+                XMVECTOR wx = XMVectorMultiplyAdd( x, XMVectorReplicate( tf.x ), XMVectorMultiplyAdd( y, XMVectorReplicate( bf.x ), XMVectorMultiply( z, XMVectorReplicate( nf.x ) ) ) );
+                XMVECTOR wy = XMVectorMultiplyAdd( x, XMVectorReplicate( tf.y ), XMVectorMultiplyAdd( y, XMVectorReplicate( bf.y ), XMVectorMultiply( z, XMVectorReplicate( nf.y ) ) ) );
+                XMVECTOR wz = XMVectorMultiplyAdd( x, XMVectorReplicate( tf.z ), XMVectorMultiplyAdd( y, XMVectorReplicate( bf.z ), XMVectorMultiply( z, XMVectorReplicate( nf.z ) ) ) );
+
+                XMFLOAT4A fx, fy, fz;
+                XMStoreFloat4A( &fx, wx );
+                XMStoreFloat4A( &fy, wy );
+                XMStoreFloat4A( &fz, wz );
+
+                const float* px = &fx.x;
+                const float* py = &fy.x;
+                const float* pz = &fz.x;
+
+                for ( size_t k = 0; k < 4 && i + k < n; ++k )
+                    out[base + i + k] = XMFLOAT3( px[k], py[k], pz[k] );
+            }
+        }
     }
-}
\ No newline at end of file
+} // namespace
+
+XMVECTOR MathHelper::RandUnitVec3()
+{
+    return UniformSphere( RandF(), RandF() );
+}
+
+XMVECTOR MathHelper::RandHemisphereUnitVec3( XMVECTOR n )
+{
+    // Reflecting the lower half onto the upper half keeps the distribution uniform.
+    XMVECTOR v = UniformSphere( RandF(), RandF() );
+
+    if ( XMVector3Less( XMVector3Dot( n, v ), XMVectorZero() ) )
+        v = XMVectorNegate( v );
+
+    return v;
+}
+
+void MathHelper::RandUnitVec3( XMFLOAT3* out, size_t count, RandomEngine& rng )
+{
+    SampleDirections( out, count, XMVectorSet( 0.0f, 0.0f, 1.0f, 0.0f ), DirectionDistribution::Cone, -1.0f, rng );
+}
+
+void MathHelper::RandHemisphereUnitVec3( XMFLOAT3* out, size_t count, FXMVECTOR n, RandomEngine& rng )
+{
+    SampleDirections( out, count, n, DirectionDistribution::Cone, 0.0f, rng );
+}
+
+void MathHelper::RandCosineHemisphereUnitVec3( XMFLOAT3* out, size_t count, FXMVECTOR n, RandomEngine& rng )
+{
+    SampleDirections( out, count, n, DirectionDistribution::Cosine, 0.0f, rng );
+}
+
+void MathHelper::RandConeUnitVec3( XMFLOAT3* out, size_t count, FXMVECTOR axis, float cosThetaMax, RandomEngine& rng )
+{
+    SampleDirections( out, count, axis, DirectionDistribution::Cone, cosThetaMax, rng );
+}
+
+void MathHelper::RandDisk( XMFLOAT2* out, size_t count, RandomEngine& rng )
+{
+    const size_t BlockSize = 64;
+    alignas( 16 ) float u[2 * BlockSize];
+
+    const XMVECTOR twoPi = XMVectorReplicate( XM_2PI );
+
+    for ( size_t base = 0; base < count; base += BlockSize )
+    {
+        size_t n       = Min( BlockSize, count - base );
+        size_t rounded = ( n + 3 ) & ~size_t( 3 );
+        rng.FillFloats( u, 2 * BlockSize );
+
+        for ( size_t i = 0; i < rounded; i += 4 )
+        {
+            XMVECTOR r = XMVectorSqrt( XMLoadFloat4A( reinterpret_cast<const XMFLOAT4A*>( &u[i] ) ) );
+            XMVECTOR sinPhi, cosPhi;
+            XMVectorSinCos( &sinPhi, &cosPhi, XMVectorMultiply( XMLoadFloat4A( reinterpret_cast<const XMFLOAT4A*>( &u[BlockSize + i] ) ), twoPi ) );
+
+            XMFLOAT4A fx, fy;
+            XMStoreFloat4A( &fx, XMVectorMultiply( r, cosPhi ) );
+            XMStoreFloat4A( &fy, XMVectorMultiply( r, sinPhi ) );
+
+            const float* px = &fx.x;
+            const float* py = &fy.x;
+
+            for ( size_t k = 0; k < 4 && i + k < n; ++k )
+                out[base + i + k] = XMFLOAT2( px[k], py[k] );
+        }
+    }
+}
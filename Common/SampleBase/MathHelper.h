@@ -9,14 +9,15 @@
 #include <Windows.h>
 #include <DirectXMath.h>
 #include <cstdint>
+#include "Random.h"
 
 class MathHelper
 {
 public:
-    // Returns random float in [0, 1).
+    // Returns random float in [0, 1).  Uses the calling thread's RandomEngine.
     static float RandF()
     {
-        return (float)( rand() ) / (float)RAND_MAX;
+        return RandomEngine::ThreadDefault().NextFloat();
     }
 
     // Returns random float in [a, b).
@@ -25,9 +26,16 @@ public:
         return a + RandF() * ( b - a );
     }
 
+    // Returns random int in [a, b].
     static int Rand( int a, int b )
     {
-        return a + rand() % ( ( b - a ) + 1 );
+        return RandomEngine::ThreadDefault().NextInt( a, b );
+    }
+
+    // Reseeds the calling thread's random stream.
+    static void SeedRandom( std::uint64_t seed )
+    {
+        RandomEngine::ThreadDefault().Seed( seed );
     }
 
     template <typename T>
@@ -57,6 +65,9 @@ public:
     // Returns the polar angle of the point (x,y) in [0, 2*PI).
     static float AngleFromXY( float x, float y );
 
+    // Batched AngleFromXY using the vectorized polynomials of SimdMath.  theta may alias x or y.
+    static void AngleFromXY( const float* x, const float* y, float* theta, size_t count );
+
     static DirectX::XMVECTOR SphericalToCartesian( float radius, float theta, float phi )
     {
         return DirectX::XMVectorSet(
@@ -66,6 +77,9 @@ public:
             1.0f );
     }
 
+    // Batched SphericalToCartesian using the vectorized polynomials of SimdMath.
+    static void SphericalToCartesian( float radius, const float* theta, const float* phi, DirectX::XMFLOAT3* out, size_t count );
+
     static DirectX::XMMATRIX InverseTranspose( DirectX::CXMMATRIX M )
     {
         // Inverse-transpose is just applied to normals.  So zero out
@@ -89,9 +103,43 @@ public:
         return I;
     }
 
+    // Uniformly distributed unit vectors on the sphere and on the hemisphere about n.
+    // Both map random numbers directly onto the sphere, so they never loop.
     static DirectX::XMVECTOR RandUnitVec3();
     static DirectX::XMVECTOR RandHemisphereUnitVec3( DirectX::XMVECTOR n );
 
+    //
+    // Batched direction samplers.  Each fills count outputs, 4 per SIMD step, drawing
+    // random numbers in bulk from rng.  Hemisphere and cone samplers are oriented
+    // about the unit vector n (or axis).
+    //
+
+    static void RandUnitVec3( DirectX::XMFLOAT3* out, size_t count, RandomEngine& rng = RandomEngine::ThreadDefault() );
+
+    static void RandHemisphereUnitVec3(
+        DirectX::XMFLOAT3* out,
+        size_t             count,
+        DirectX::FXMVECTOR n,
+        RandomEngine&      rng = RandomEngine::ThreadDefault() );
+
+    // Cosine-weighted (pdf = cos(theta) / pi) hemisphere directions about n.
+    static void RandCosineHemisphereUnitVec3(
+        DirectX::XMFLOAT3* out,
+        size_t             count,
+        DirectX::FXMVECTOR n,
+        RandomEngine&      rng = RandomEngine::ThreadDefault() );
+
+    // Uniform directions within the cone of half-angle acos(cosThetaMax) about axis.
+    static void RandConeUnitVec3(
+        DirectX::XMFLOAT3* out,
+        size_t             count,
+        DirectX::FXMVECTOR axis,
+        float              cosThetaMax,
+        RandomEngine&      rng = RandomEngine::ThreadDefault() );
+
+    // Uniform points on the unit disk.
+    static void RandDisk( DirectX::XMFLOAT2* out, size_t count, RandomEngine& rng = RandomEngine::ThreadDefault() );
+
     static const float Infinity;
     static const float Pi;
 };
@@ -0,0 +1,316 @@
+//***************************************************************************************
+// OcclusionCulling.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "OcclusionCulling.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <immintrin.h>
+
+using namespace DirectX;
+
+const int OcclusionBuffer::TileSize;
+const int OcclusionBuffer::BlockSize;
+
+namespace
+{
+    // Objects per thread pool task in FilterVisible.
+    const size_t FilterGrainSize = 1024;
+
+    inline XMFLOAT4 Lerp( const XMFLOAT4& a, const XMFLOAT4& b, float t )
+    {
+        return XMFLOAT4( a.x + ( b.x - a.x ) * t, a.y + ( b.y - a.y ) * t, a.z + ( b.z - a.z ) * t, a.w + ( b.w - a.w ) * t );
+    }
+
+    // Clips a clip space triangle against the near plane z >= 0.  Returns the number of
+    // vertices of the resulting convex polygon (0, 3 or 4).
+    int ClipNear( const XMFLOAT4 in[3], XMFLOAT4 out[4] )
+    {
+        int count = 0;
+        for ( int i = 0; i < 3; ++i )
+        {
+            const XMFLOAT4& a = in[i];
+            const XMFLOAT4& b = in[( i + 1 ) % 3];
+
+            if ( a.z >= 0.0f )
+                out[count++] = a;
+            if ( ( a.z >= 0.0f ) != ( b.z >= 0.0f ) )
+                out[count++] = Lerp( a, b, a.z / ( a.z - b.z ) );
+        }
+        return count;
+    }
+} // namespace
+
+OcclusionBuffer::OcclusionBuffer( int width, int height )
+    : mWidth( width )
+    , mHeight( height )
+    , mTilesX( width / TileSize )
+    , mTilesY( height / TileSize )
+    , mTileTriangles( mTilesX * mTilesY )
+    , mDepth( static_cast<size_t>( width ) * height, 1.0f )
+    , mBlockDepth( static_cast<size_t>( width / BlockSize ) * ( height / BlockSize ), 1.0f )
+{
+    assert( width > 0 && width % TileSize == 0 );
+    assert( height > 0 && height % TileSize == 0 );
+
+    XMStoreFloat4x4( &mViewProj, XMMatrixIdentity() );
+}
+
+void XM_CALLCONV OcclusionBuffer::Begin( FXMMATRIX viewProj )
+{
+    XMStoreFloat4x4( &mViewProj, viewProj );
+
+    mTriangles.clear();
+    for ( auto& tile : mTileTriangles )
+        tile.clear();
+}
+
+void XM_CALLCONV OcclusionBuffer::AddOccluder( const XMFLOAT3* positions, size_t positionStrideInBytes,
+                                               const std::uint32_t* indices, size_t indexCount, FXMMATRIX world )
+{
+    assert( indexCount % 3 == 0 );
+
+    XMMATRIX worldViewProj = XMMatrixMultiply( world, XMLoadFloat4x4( &mViewProj ) );
+
+    auto load = [&]( std::uint32_t index ) {
+        const XMFLOAT3* p = reinterpret_cast<const XMFLOAT3*>( reinterpret_cast<const BYTE*>( positions ) + index * positionStrideInBytes );
+        XMFLOAT4 clip;
+        XMStoreFloat4( &clip, XMVector3Transform( XMLoadFloat3( p ), worldViewProj ) );
+        return clip;
+    };
+
+    for ( size_t i = 0; i < indexCount; i += 3 )
+    {
+        XMFLOAT4 clip[3] = { load( indices[i] ), load( indices[i + 1] ), load( indices[i + 2] ) };
+
+        // Trivially reject triangles outside one of the side or far planes.
+        bool outside = false;
+        outside |= clip[0].x > clip[0].w && clip[1].x > clip[1].w && clip[2].x > clip[2].w;
+        outside |= clip[0].x < -clip[0].w && clip[1].x < -clip[1].w && clip[2].x < -clip[2].w;
+        outside |= clip[0].y > clip[0].w && clip[1].y > clip[1].w && clip[2].y > clip[2].w;
+        outside |= clip[0].y < -clip[0].w && clip[1].y < -clip[1].w && clip[2].y < -clip[2].w;
+        outside |= clip[0].z > clip[0].w && clip[1].z > clip[1].w && clip[2].z > clip[2].w;
+        if ( outside )
+            continue;
+
+        XMFLOAT4 polygon[4];
+        int      count = ClipNear( clip, polygon );
+        for ( int k = 2; k < count; ++k )
+            AddTriangle( polygon[0], polygon[k - 1], polygon[k] );
+    }
+}
+
+void OcclusionBuffer::AddTriangle( const XMFLOAT4& c0, const XMFLOAT4& c1, const XMFLOAT4& c2 )
+{
+    // To pixels, with y down and pixel centers at half integers.
+    const XMFLOAT4* clip[3] = { &c0, &c1, &c2 };
+    float           x[3], y[3], z[3];
+    for ( int i = 0; i < 3; ++i )
+    {
+        float invW = 1.0f / clip[i]->w;
+        x[i]       = ( clip[i]->x * invW * 0.5f + 0.5f ) * mWidth;
+        y[i]       = ( 0.5f - clip[i]->y * invW * 0.5f ) * mHeight;
+        z[i]       = clip[i]->z * invW;
+    }
+
+    // Clockwise on screen (front facing) triangles have positive area.
+    float area = ( x[1] - x[0] ) * ( y[2] - y[0] ) - ( x[2] - x[0] ) * ( y[1] - y[0] );
+    if ( !( area > 0.0f ) )
+        return;
+
+    // Pixels whose centers can be covered, clamped to the screen.
+    auto toPixel = [&]( float v, int size ) {
+        return static_cast<int>( std::min<float>( std::max<float>( v, -1.0f ), static_cast<float>( size ) ) );
+    };
+
+    Triangle t;
+    t.MinX = std::max<int>( toPixel( std::floor( std::min<float>( x[0], std::min<float>( x[1], x[2] ) ) - 0.5f ), mWidth ), 0 );
+    t.MinY = std::max<int>( toPixel( std::floor( std::min<float>( y[0], std::min<float>( y[1], y[2] ) ) - 0.5f ), mHeight ), 0 );
+    t.MaxX = std::min<int>( toPixel( std::ceil( std::max<float>( x[0], std::max<float>( x[1], x[2] ) ) - 0.5f ), mWidth ), mWidth - 1 );
+    t.MaxY = std::min<int>( toPixel( std::ceil( std::max<float>( y[0], std::max<float>( y[1], y[2] ) ) - 0.5f ), mHeight ), mHeight - 1 );
+    if ( t.MinX > t.MaxX || t.MinY > t.MaxY )
+        return;
+
+    // Edge i runs from vertex i to vertex i + 1 and is opposite to vertex i + 2.
+    for ( int i = 0; i < 3; ++i )
+    {
+        int j      = ( i + 1 ) % 3;
+        t.EdgeA[i] = y[i] - y[j];
+        t.EdgeB[i] = x[j] - x[i];
+        t.EdgeC[i] = -( t.EdgeA[i] * x[i] + t.EdgeB[i] * y[i] );
+    }
+
+    // z is affine in screen space: z = sum over edges of E_i(p) z_(i+2) / area.
+    float invArea = 1.0f / area;
+    t.DepthA      = ( t.EdgeA[0] * z[2] + t.EdgeA[1] * z[0] + t.EdgeA[2] * z[1] ) * invArea;
+    t.DepthB      = ( t.EdgeB[0] * z[2] + t.EdgeB[1] * z[0] + t.EdgeB[2] * z[1] ) * invArea;
+    t.DepthC      = ( t.EdgeC[0] * z[2] + t.EdgeC[1] * z[0] + t.EdgeC[2] * z[1] ) * invArea;
+
+    std::uint32_t index = static_cast<std::uint32_t>( mTriangles.size() );
+    mTriangles.push_back( t );
+
+    for ( int ty = t.MinY / TileSize; ty <= t.MaxY / TileSize; ++ty )
+        for ( int tx = t.MinX / TileSize; tx <= t.MaxX / TileSize; ++tx )
+            mTileTriangles[ty * mTilesX + tx].push_back( index );
+}
+
+void OcclusionBuffer::Rasterize( ThreadPool& pool )
+{
+    pool.ParallelFor( mTileTriangles.size(), 1, [this]( size_t begin, size_t end ) {
+        for ( size_t tile = begin; tile < end; ++tile )
+            RasterizeTile( static_cast<int>( tile % mTilesX ), static_cast<int>( tile / mTilesX ) );
+    } );
+}
+
+void OcclusionBuffer::RasterizeTile( int tileX, int tileY )
+{
+    const int x0 = tileX * TileSize;
+    const int y0 = tileY * TileSize;
+
+    for ( int y = y0; y < y0 + TileSize; ++y )
+        std::fill_n( &mDepth[static_cast<size_t>( y ) * mWidth + x0], TileSize, 1.0f );
+
+    const __m128 pixelOffset = _mm_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f );
+
+    for ( std::uint32_t index : mTileTriangles[tileY * mTilesX + tileX] )
+    {
+        const Triangle& t = mTriangles[index];
+
+        // Steps of 4 pixels, starting at a multiple of 4 inside the tile.
+        int minX = std::max<int>( t.MinX, x0 ) & ~3;
+        int maxX = std::min<int>( t.MaxX, x0 + TileSize - 1 );
+        int minY = std::max<int>( t.MinY, y0 );
+        int maxY = std::min<int>( t.MaxY, y0 + TileSize - 1 );
+
+        __m128 edgeA[3], edgeB[3], edgeC[3];
+        for ( int i = 0; i < 3; ++i )
+        {
+            edgeA[i] = _mm_set1_ps( t.EdgeA[i] );
+            edgeB[i] = _mm_set1_ps( t.EdgeB[i] );
+            edgeC[i] = _mm_set1_ps( t.EdgeC[i] );
+        }
+        __m128 depthA = _mm_set1_ps( t.DepthA );
+        __m128 depthB = _mm_set1_ps( t.DepthB );
+        __m128 depthC = _mm_set1_ps( t.DepthC );
+
+        for ( int y = minY; y <= maxY; ++y )
+        {
+            __m128 py    = _mm_set1_ps( y + 0.5f );
+            float* depth = &mDepth[static_cast<size_t>( y ) * mWidth];
+
+            for ( int x = minX; x <= maxX; x += 4 )
+            {
+                __m128 px = _mm_add_ps( _mm_set1_ps( static_cast<float>( x ) ), pixelOffset );
+
+                __m128 inside = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+                for ( int i = 0; i < 3; ++i )
+                {
+                    __m128 e = _mm_add_ps( _mm_add_ps( _mm_mul_ps( edgeA[i], px ), _mm_mul_ps( edgeB[i], py ) ), edgeC[i] );
+                    inside   = _mm_and_ps( inside, _mm_cmpge_ps( e, _mm_setzero_ps() ) );
+                }
+                if ( _mm_movemask_ps( inside ) == 0 )
+                    continue;
+
+                __m128 z       = _mm_add_ps( _mm_add_ps( _mm_mul_ps( depthA, px ), _mm_mul_ps( depthB, py ) ), depthC );
+                __m128 old     = _mm_loadu_ps( depth + x );
+                __m128 nearest = _mm_min_ps( old, z );
+                _mm_storeu_ps( depth + x, _mm_or_ps( _mm_and_ps( inside, nearest ), _mm_andnot_ps( inside, old ) ) );
+            }
+        }
+    }
+
+    // Farthest depth of each block of the tile.
+    const int blocksX = mWidth / BlockSize;
+    for ( int by = y0 / BlockSize; by < ( y0 + TileSize ) / BlockSize; ++by )
+    {
+        for ( int bx = x0 / BlockSize; bx < ( x0 + TileSize ) / BlockSize; ++bx )
+        {
+            __m128 farthest = _mm_setzero_ps();
+            for ( int y = by * BlockSize; y < ( by + 1 ) * BlockSize; ++y )
+            {
+                const float* row = &mDepth[static_cast<size_t>( y ) * mWidth + bx * BlockSize];
+                farthest         = _mm_max_ps( farthest, _mm_max_ps( _mm_loadu_ps( row ), _mm_loadu_ps( row + 4 ) ) );
+            }
+            farthest = _mm_max_ps( farthest, _mm_shuffle_ps( farthest, farthest, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+            farthest = _mm_max_ps( farthest, _mm_shuffle_ps( farthest, farthest, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+            mBlockDepth[by * blocksX + bx] = _mm_cvtss_f32( farthest );
+        }
+    }
+}
+
+bool OcclusionBuffer::IsVisible( const BoundingBox& box ) const
+{
+    XMMATRIX viewProj = XMLoadFloat4x4( &mViewProj );
+
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    float nearestZ      = FLT_MAX;
+    int   behindCorners = 0;
+    for ( int i = 0; i < 8; ++i )
+    {
+        XMVECTOR corner = XMVectorSet( box.Center.x + ( ( i & 1 ) ? box.Extents.x : -box.Extents.x ),
+                                       box.Center.y + ( ( i & 2 ) ? box.Extents.y : -box.Extents.y ),
+                                       box.Center.z + ( ( i & 4 ) ? box.Extents.z : -box.Extents.z ), 1.0f );
+        XMFLOAT4 clip;
+        XMStoreFloat4( &clip, XMVector4Transform( corner, viewProj ) );
+        if ( clip.z < 0.0f )
+        {
+            ++behindCorners;
+            continue;
+        }
+
+        float invW = 1.0f / clip.w;
+        float x    = ( clip.x * invW * 0.5f + 0.5f ) * mWidth;
+        float y    = ( 0.5f - clip.y * invW * 0.5f ) * mHeight;
+        minX       = std::min<float>( minX, x );
+        maxX       = std::max<float>( maxX, x );
+        minY       = std::min<float>( minY, y );
+        maxY       = std::max<float>( maxY, y );
+        nearestZ   = std::min<float>( nearestZ, clip.z * invW );
+    }
+
+    if ( behindCorners > 0 )
+        return behindCorners < 8;
+    if ( maxX < 0.0f || maxY < 0.0f || minX > mWidth || minY > mHeight )
+        return false;
+
+    // Blocks touched by the rectangle.
+    const int blocksX = mWidth / BlockSize;
+    int       bx0     = static_cast<int>( std::max<float>( minX, 0.0f ) ) / BlockSize;
+    int       by0     = static_cast<int>( std::max<float>( minY, 0.0f ) ) / BlockSize;
+    int       bx1     = static_cast<int>( std::min<float>( maxX, mWidth - 1.0f ) ) / BlockSize;
+    int       by1     = static_cast<int>( std::min<float>( maxY, mHeight - 1.0f ) ) / BlockSize;
+
+    for ( int by = by0; by <= by1; ++by )
+        for ( int bx = bx0; bx <= bx1; ++bx )
+            if ( nearestZ <= mBlockDepth[by * blocksX + bx] )
+                return true;
+    return false;
+}
+
+void OcclusionBuffer::FilterVisible( const BoxBoundsSoA& bounds, std::vector<std::uint32_t>& indices, ThreadPool& pool ) const
+{
+    std::vector<std::uint8_t> visible( indices.size() );
+    pool.ParallelFor( indices.size(), FilterGrainSize, [&]( size_t begin, size_t end ) {
+        for ( size_t i = begin; i < end; ++i )
+        {
+            std::uint32_t object = indices[i];
+
+            BoundingBox box;
+            box.Center  = XMFLOAT3( bounds.CenterX()[object], bounds.CenterY()[object], bounds.CenterZ()[object] );
+            box.Extents = XMFLOAT3( bounds.ExtentX()[object], bounds.ExtentY()[object], bounds.ExtentZ()[object] );
+            visible[i]  = IsVisible( box ) ? 1 : 0;
+        }
+    } );
+
+    size_t count = 0;
+    for ( size_t i = 0; i < indices.size(); ++i )
+    {
+        if ( visible[i] )
+            indices[count++] = indices[i];
+    }
+    indices.resize( count );
+}
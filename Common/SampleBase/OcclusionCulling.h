@@ -0,0 +1,97 @@
+//***************************************************************************************
+// OcclusionCulling.h
+//
+// CPU software occlusion culling.
+//
+// A few large, simple meshes (walls, terrain chunks, building shells) are rasterized as
+// occluders into a small depth buffer, and the bounding boxes of the remaining objects
+// are tested against it before they are drawn.  Each frame: Begin, AddOccluder for
+// each occluder, Rasterize, then test.
+//
+// Triangles are binned into 32x32 pixel tiles, and the tiles are rasterized in parallel
+// on the thread pool with SSE edge functions, 4 pixels per step.  Each tile then
+// reduces its depth to the farthest value of every 8x8 block.  Box tests project the
+// 8 corners and compare the box's nearest depth with the blocks its screen rectangle
+// covers, so a box is only reported occluded when it is entirely behind occluders.
+//
+// Depth is the D3D z/w in [0, 1] with 0 at the near plane, and occluders use the D3D
+// winding: clockwise triangles are front faces and back faces are culled.
+//***************************************************************************************
+
+#pragma once
+
+#include "FrustumCulling.h"
+#include "ThreadPool.h"
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <vector>
+
+class OcclusionBuffer
+{
+public:
+    static const int TileSize  = 32;
+    static const int BlockSize = 8;
+
+    // width and height must be multiples of TileSize.
+    explicit OcclusionBuffer( int width = 256, int height = 128 );
+
+    int GetWidth() const { return mWidth; }
+    int GetHeight() const { return mHeight; }
+
+    // Starts a new frame seen through viewProj, e.g. Camera::GetViewProj().
+    void XM_CALLCONV Begin( DirectX::FXMMATRIX viewProj );
+
+    // Transforms an indexed triangle list by world and bins its triangles.
+    void XM_CALLCONV AddOccluder( const DirectX::XMFLOAT3* positions, size_t positionStrideInBytes,
+                                  const std::uint32_t* indices, size_t indexCount, DirectX::FXMMATRIX world );
+
+    // Rasterizes the binned triangles and builds the block depths used by the tests.
+    void Rasterize( ThreadPool& pool = ThreadPool::Default() );
+
+    // Returns false if the world space box is entirely hidden behind occluders, off
+    // screen or behind the near plane.  Boxes that cross the near plane are visible.
+    bool IsVisible( const DirectX::BoundingBox& box ) const;
+
+    // Removes the occluded objects from indices, e.g. the output of FrustumCulling::Cull,
+    // keeping the order of the others.
+    void FilterVisible( const BoxBoundsSoA& bounds, std::vector<std::uint32_t>& indices,
+                        ThreadPool& pool = ThreadPool::Default() ) const;
+
+    // Full resolution depth, row by row, for debugging.
+    const float* GetDepth() const { return mDepth.data(); }
+
+private:
+    // Screen space triangle: edge functions A x + B y + C >= 0 inside, and the depth plane.
+    struct Triangle
+    {
+        float EdgeA[3];
+        float EdgeB[3];
+        float EdgeC[3];
+        float DepthA;
+        float DepthB;
+        float DepthC;
+        int   MinX;
+        int   MinY;
+        int   MaxX;
+        int   MaxY;
+    };
+
+    void AddTriangle( const DirectX::XMFLOAT4& v0, const DirectX::XMFLOAT4& v1, const DirectX::XMFLOAT4& v2 );
+    void RasterizeTile( int tileX, int tileY );
+
+private:
+    int mWidth;
+    int mHeight;
+    int mTilesX;
+    int mTilesY;
+
+    DirectX::XMFLOAT4X4 mViewProj;
+
+    std::vector<Triangle>                   mTriangles;
+    std::vector<std::vector<std::uint32_t>> mTileTriangles;
+
+    std::vector<float> mDepth;
+
+    // Farthest depth of each BlockSize x BlockSize block.
+    std::vector<float> mBlockDepth;
+};
@@ -0,0 +1,342 @@
+//***************************************************************************************
+// PackedConvert.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "PackedConvert.h"
+#include "CpuFeatures.h"
+#include <cmath>
+#include <immintrin.h>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+    //
+    // Scalar conversions.  Used for the tail of every batch.
+    //
+
+    inline std::uint8_t ToUNorm8( float x )
+    {
+        // Written so that NaN ends up at 0, like maxps in the SIMD path.
+        x = x > 0.0f ? ( x < 1.0f ? x : 1.0f ) : 0.0f;
+        return (std::uint8_t)( x * 255.0f + 0.5f );
+    }
+
+    inline std::int16_t ToSNorm16( float x )
+    {
+        x = x > -1.0f ? ( x < 1.0f ? x : 1.0f ) : -1.0f;
+        x *= 32767.0f;
+        return (std::int16_t)( x + ( x < 0.0f ? -0.5f : 0.5f ) );
+    }
+
+    inline float FromSNorm16( std::int16_t x )
+    {
+        float f = x * ( 1.0f / 32767.0f );
+        return f > -1.0f ? f : -1.0f;
+    }
+
+    inline float SignNotZero( float x )
+    {
+        return x < 0.0f ? -1.0f : 1.0f;
+    }
+
+    void EncodeOctahedralScalar( const XMFLOAT3& n, std::int16_t* out )
+    {
+        float sum = fabsf( n.x ) + fabsf( n.y ) + fabsf( n.z );
+        float inv = sum > 0.0f ? 1.0f / sum : 0.0f;
+        float px  = n.x * inv;
+        float py  = n.y * inv;
+
+        // Fold the lower hemisphere over the diagonals.
+        if ( n.z < 0.0f )
+        {
+            float fx = ( 1.0f - fabsf( py ) ) * SignNotZero( px );
+            float fy = ( 1.0f - fabsf( px ) ) * SignNotZero( py );
+            px       = fx;
+            py       = fy;
+        }
+
+        out[0] = ToSNorm16( px );
+        out[1] = ToSNorm16( py );
+    }
+
+    void DecodeOctahedralScalar( const std::int16_t* in, XMFLOAT3& n )
+    {
+        float x = FromSNorm16( in[0] );
+        float y = FromSNorm16( in[1] );
+        float z = 1.0f - fabsf( x ) - fabsf( y );
+
+        // Unfold the lower hemisphere.
+        float t = z < 0.0f ? -z : 0.0f;
+        x += x < 0.0f ? t : -t;
+        y += y < 0.0f ? t : -t;
+
+        float invLen = 1.0f / sqrtf( x * x + y * y + z * z );
+        n.x          = x * invLen;
+        n.y          = y * invLen;
+        n.z          = z * invLen;
+    }
+
+    //
+    // F16C/AVX2 kernels, 8 elements per iteration.  Return the number of elements processed.
+    //
+
+    size_t FloatToHalfF16C( const float* in, HALF* out, size_t count )
+    {
+        size_t n = count - count % 8;
+        for ( size_t i = 0; i < n; i += 8 )
+        {
+            __m128i h = _mm256_cvtps_ph( _mm256_loadu_ps( in + i ), _MM_FROUND_TO_NEAREST_INT );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( out + i ), h );
+        }
+        return n;
+    }
+
+    size_t HalfToFloatF16C( const HALF* in, float* out, size_t count )
+    {
+        size_t n = count - count % 8;
+        for ( size_t i = 0; i < n; i += 8 )
+        {
+            __m128i h = _mm_loadu_si128( reinterpret_cast<const __m128i*>( in + i ) );
+            _mm256_storeu_ps( out + i, _mm256_cvtph_ps( h ) );
+        }
+        return n;
+    }
+
+    size_t FloatToUNorm8AVX2( const float* in, std::uint8_t* out, size_t count )
+    {
+        const __m256 zero  = _mm256_setzero_ps();
+        const __m256 one   = _mm256_set1_ps( 1.0f );
+        const __m256 scale = _mm256_set1_ps( 255.0f );
+        const __m256 half  = _mm256_set1_ps( 0.5f );
+
+        size_t n = count - count % 8;
+        for ( size_t i = 0; i < n; i += 8 )
+        {
+            // maxps returns the second operand for NaN, so NaN maps to 0.
+            __m256  v = _mm256_min_ps( _mm256_max_ps( _mm256_loadu_ps( in + i ), zero ), one );
+            __m256i q = _mm256_cvttps_epi32( _mm256_add_ps( _mm256_mul_ps( v, scale ), half ) );
+
+            __m128i w = _mm_packus_epi32( _mm256_castsi256_si128( q ), _mm256_extracti128_si256( q, 1 ) );
+            _mm_storel_epi64( reinterpret_cast<__m128i*>( out + i ), _mm_packus_epi16( w, w ) );
+        }
+        return n;
+    }
+
+    size_t UNorm8ToFloatAVX2( const std::uint8_t* in, float* out, size_t count )
+    {
+        const __m256 scale = _mm256_set1_ps( 1.0f / 255.0f );
+
+        size_t n = count - count % 8;
+        for ( size_t i = 0; i < n; i += 8 )
+        {
+            __m256i q = _mm256_cvtepu8_epi32( _mm_loadl_epi64( reinterpret_cast<const __m128i*>( in + i ) ) );
+            _mm256_storeu_ps( out + i, _mm256_mul_ps( _mm256_cvtepi32_ps( q ), scale ) );
+        }
+        return n;
+    }
+
+    inline __m256i ToSNorm16AVX2( __m256 v )
+    {
+        const __m256 signMask = _mm256_set1_ps( -0.0f );
+
+        v = _mm256_min_ps( _mm256_max_ps( v, _mm256_set1_ps( -1.0f ) ), _mm256_set1_ps( 1.0f ) );
+        v = _mm256_mul_ps( v, _mm256_set1_ps( 32767.0f ) );
+
+        // Round half away from zero: add +-0.5 and truncate.
+        __m256 bias = _mm256_or_ps( _mm256_set1_ps( 0.5f ), _mm256_and_ps( v, signMask ) );
+        return _mm256_cvttps_epi32( _mm256_add_ps( v, bias ) );
+    }
+
+    inline __m256 FromSNorm16AVX2( __m256i q )
+    {
+        __m256 f = _mm256_mul_ps( _mm256_cvtepi32_ps( q ), _mm256_set1_ps( 1.0f / 32767.0f ) );
+        return _mm256_max_ps( f, _mm256_set1_ps( -1.0f ) );
+    }
+
+    size_t FloatToSNorm16AVX2( const float* in, std::int16_t* out, size_t count )
+    {
+        size_t n = count - count % 8;
+        for ( size_t i = 0; i < n; i += 8 )
+        {
+            __m256i q = ToSNorm16AVX2( _mm256_loadu_ps( in + i ) );
+            __m128i w = _mm_packs_epi32( _mm256_castsi256_si128( q ), _mm256_extracti128_si256( q, 1 ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( out + i ), w );
+        }
+        return n;
+    }
+
+    size_t SNorm16ToFloatAVX2( const std::int16_t* in, float* out, size_t count )
+    {
+        size_t n = count - count % 8;
+        for ( size_t i = 0; i < n; i += 8 )
+        {
+            __m256i q = _mm256_cvtepi16_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( in + i ) ) );
+            _mm256_storeu_ps( out + i, FromSNorm16AVX2( q ) );
+        }
+        return n;
+    }
+
+    size_t EncodeOctahedralAVX2( const XMFLOAT3* in, size_t inStrideInBytes, size_t count, std::int16_t* out )
+    {
+        const __m256 signMask = _mm256_set1_ps( -0.0f );
+        const __m256 zero     = _mm256_setzero_ps();
+        const __m256 one      = _mm256_set1_ps( 1.0f );
+
+        const BYTE* src = reinterpret_cast<const BYTE*>( in );
+
+        size_t n = count - count % 8;
+        for ( size_t i = 0; i < n; i += 8 )
+        {
+            // Gather 8 strided vectors into SoA registers.
+            alignas( 32 ) float x[8], y[8], z[8];
+            for ( size_t k = 0; k < 8; ++k, src += inStrideInBytes )
+            {
+                const XMFLOAT3* v = reinterpret_cast<const XMFLOAT3*>( src );
+                x[k]              = v->x;
+                y[k]              = v->y;
+                z[k]              = v->z;
+            }
+
+            __m256 vx = _mm256_load_ps( x );
+            __m256 vy = _mm256_load_ps( y );
+            __m256 vz = _mm256_load_ps( z );
+
+            __m256 ax  = _mm256_andnot_ps( signMask, vx );
+            __m256 ay  = _mm256_andnot_ps( signMask, vy );
+            __m256 az  = _mm256_andnot_ps( signMask, vz );
+            __m256 sum = _mm256_add_ps( _mm256_add_ps( ax, ay ), az );
+            __m256 inv = _mm256_and_ps( _mm256_div_ps( one, sum ), _mm256_cmp_ps( sum, zero, _CMP_GT_OQ ) );
+
+            __m256 px = _mm256_mul_ps( vx, inv );
+            __m256 py = _mm256_mul_ps( vy, inv );
+
+            // Fold the lower hemisphere over the diagonals.
+            __m256 sx = _mm256_or_ps( one, _mm256_and_ps( _mm256_cmp_ps( px, zero, _CMP_LT_OQ ), signMask ) );
+            __m256 sy = _mm256_or_ps( one, _mm256_and_ps( _mm256_cmp_ps( py, zero, _CMP_LT_OQ ), signMask ) );
+            __m256 fx = _mm256_mul_ps( _mm256_sub_ps( one, _mm256_andnot_ps( signMask, py ) ), sx );
+            __m256 fy = _mm256_mul_ps( _mm256_sub_ps( one, _mm256_andnot_ps( signMask, px ) ), sy );
+
+            __m256 lower = _mm256_cmp_ps( vz, zero, _CMP_LT_OQ );
+            px           = _mm256_blendv_ps( px, fx, lower );
+            py           = _mm256_blendv_ps( py, fy, lower );
+
+            // Interleave to (x, y) pairs.  unpack and packs both work per 128-bit lane,
+            // so the two lane swaps cancel and the result is already in order.
+            __m256i qx = ToSNorm16AVX2( px );
+            __m256i qy = ToSNorm16AVX2( py );
+            __m256i lo = _mm256_unpacklo_epi32( qx, qy ); // x0 y0 x1 y1 | x4 y4 x5 y5
+            __m256i hi = _mm256_unpackhi_epi32( qx, qy ); // x2 y2 x3 y3 | x6 y6 x7 y7
+            __m256i w  = _mm256_packs_epi32( lo, hi );    // x0 y0 .. x3 y3 | x4 y4 .. x7 y7
+            _mm256_storeu_si256( reinterpret_cast<__m256i*>( out + 2 * i ), w );
+        }
+        return n;
+    }
+
+    size_t DecodeOctahedralAVX2( const std::int16_t* in, size_t count, XMFLOAT3* out, size_t outStrideInBytes )
+    {
+        const __m256 signMask = _mm256_set1_ps( -0.0f );
+        const __m256 zero     = _mm256_setzero_ps();
+        const __m256 one      = _mm256_set1_ps( 1.0f );
+
+        BYTE* dst = reinterpret_cast<BYTE*>( out );
+
+        size_t n = count - count % 8;
+        for ( size_t i = 0; i < n; i += 8 )
+        {
+            // 8 (x, y) pairs as 32-bit lanes; sign extend the low and high halves.
+            __m256i pairs = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( in + 2 * i ) );
+            __m256i qx    = _mm256_srai_epi32( _mm256_slli_epi32( pairs, 16 ), 16 );
+            __m256i qy    = _mm256_srai_epi32( pairs, 16 );
+
+            __m256 x = FromSNorm16AVX2( qx );
+            __m256 y = FromSNorm16AVX2( qy );
+            __m256 z = _mm256_sub_ps( _mm256_sub_ps( one, _mm256_andnot_ps( signMask, x ) ),
+                                      _mm256_andnot_ps( signMask, y ) );
+
+            // Unfold the lower hemisphere: x -= copysign( t, x ).
+            __m256 t  = _mm256_max_ps( _mm256_sub_ps( zero, z ), zero );
+            __m256 tx = _mm256_or_ps( t, _mm256_and_ps( _mm256_cmp_ps( x, zero, _CMP_LT_OQ ), signMask ) );
+            __m256 ty = _mm256_or_ps( t, _mm256_and_ps( _mm256_cmp_ps( y, zero, _CMP_LT_OQ ), signMask ) );
+            x         = _mm256_sub_ps( x, tx );
+            y         = _mm256_sub_ps( y, ty );
+
+            __m256 lenSq  = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( x, x ), _mm256_mul_ps( y, y ) ), _mm256_mul_ps( z, z ) );
+            __m256 invLen = _mm256_div_ps( one, _mm256_sqrt_ps( lenSq ) );
+
+            alignas( 32 ) float fx[8], fy[8], fz[8];
+            _mm256_store_ps( fx, _mm256_mul_ps( x, invLen ) );
+            _mm256_store_ps( fy, _mm256_mul_ps( y, invLen ) );
+            _mm256_store_ps( fz, _mm256_mul_ps( z, invLen ) );
+            for ( size_t k = 0; k < 8; ++k, dst += outStrideInBytes )
+            {
+                XMFLOAT3* v = reinterpret_cast<XMFLOAT3*>( dst );
+                v->x        = fx[k];
+                v->y        = fy[k];
+                v->z        = fz[k];
+            }
+        }
+        return n;
+    }
+} // namespace
+
+void PackedConvert::FloatToHalf( const float* in, HALF* out, size_t count )
+{
+    size_t done = CpuFeatures::HasF16C() ? FloatToHalfF16C( in, out, count ) : 0;
+    XMConvertFloatToHalfStream( out + done, sizeof( HALF ), in + done, sizeof( float ), count - done );
+}
+
+void PackedConvert::HalfToFloat( const HALF* in, float* out, size_t count )
+{
+    size_t done = CpuFeatures::HasF16C() ? HalfToFloatF16C( in, out, count ) : 0;
+    XMConvertHalfToFloatStream( out + done, sizeof( float ), in + done, sizeof( HALF ), count - done );
+}
+
+void PackedConvert::FloatToUNorm8( const float* in, std::uint8_t* out, size_t count )
+{
+    size_t done = CpuFeatures::HasAVX2() ? FloatToUNorm8AVX2( in, out, count ) : 0;
+    for ( size_t i = done; i < count; ++i )
+        out[i] = ToUNorm8( in[i] );
+}
+
+void PackedConvert::UNorm8ToFloat( const std::uint8_t* in, float* out, size_t count )
+{
+    size_t done = CpuFeatures::HasAVX2() ? UNorm8ToFloatAVX2( in, out, count ) : 0;
+    for ( size_t i = done; i < count; ++i )
+        out[i] = in[i] * ( 1.0f / 255.0f );
+}
+
+void PackedConvert::FloatToSNorm16( const float* in, std::int16_t* out, size_t count )
+{
+    size_t done = CpuFeatures::HasAVX2() ? FloatToSNorm16AVX2( in, out, count ) : 0;
+    for ( size_t i = done; i < count; ++i )
+        out[i] = ToSNorm16( in[i] );
+}
+
+void PackedConvert::SNorm16ToFloat( const std::int16_t* in, float* out, size_t count )
+{
+    size_t done = CpuFeatures::HasAVX2() ? SNorm16ToFloatAVX2( in, out, count ) : 0;
+    for ( size_t i = done; i < count; ++i )
+        out[i] = FromSNorm16( in[i] );
+}
+
+void PackedConvert::EncodeOctahedral( const XMFLOAT3* in, size_t inStrideInBytes, size_t count, std::int16_t* out )
+{
+    size_t done = CpuFeatures::HasAVX2() ? EncodeOctahedralAVX2( in, inStrideInBytes, count, out ) : 0;
+
+    const BYTE* src = reinterpret_cast<const BYTE*>( in ) + done * inStrideInBytes;
+    for ( size_t i = done; i < count; ++i, src += inStrideInBytes )
+        EncodeOctahedralScalar( *reinterpret_cast<const XMFLOAT3*>( src ), out + 2 * i );
+}
+
+void PackedConvert::DecodeOctahedral( const std::int16_t* in, size_t count, XMFLOAT3* out, size_t outStrideInBytes )
+{
+    size_t done = CpuFeatures::HasAVX2() ? DecodeOctahedralAVX2( in, count, out, outStrideInBytes ) : 0;
+
+    BYTE* dst = reinterpret_cast<BYTE*>( out ) + done * outStrideInBytes;
+    for ( size_t i = done; i < count; ++i, dst += outStrideInBytes )
+        DecodeOctahedralScalar( in + 2 * i, *reinterpret_cast<XMFLOAT3*>( dst ) );
+}
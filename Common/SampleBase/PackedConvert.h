@@ -0,0 +1,44 @@
+//***************************************************************************************
+// PackedConvert.h
+//
+// Bulk conversion between float and compact vertex/texture/constant formats.
+//
+// Array versions of the element-wise conversions in DirectXPackedVector.h.  Uses F16C
+// and AVX2 to convert 8 elements per instruction when the CPU supports them, and falls
+// back to scalar code otherwise.  Both paths round the same way, so results only depend
+// on the CPU for half-float NaN payloads.
+//
+// Normalized integer conversions follow the D3D rules: the input is clamped to the
+// representable range (NaN becomes the lower bound), scaled, and rounded to nearest
+// with ties away from zero.  snorm -1 is encoded as -32767, so -32768 decodes to -1 too.
+//***************************************************************************************
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include <cstddef>
+#include <cstdint>
+
+class PackedConvert
+{
+public:
+    static void FloatToHalf( const float* in, DirectX::PackedVector::HALF* out, size_t count );
+    static void HalfToFloat( const DirectX::PackedVector::HALF* in, float* out, size_t count );
+
+    static void FloatToUNorm8( const float* in, std::uint8_t* out, size_t count );
+    static void UNorm8ToFloat( const std::uint8_t* in, float* out, size_t count );
+
+    static void FloatToSNorm16( const float* in, std::int16_t* out, size_t count );
+    static void SNorm16ToFloat( const std::int16_t* in, float* out, size_t count );
+
+    ///<summary>
+    /// Octahedral encoding of unit vectors (Meyer et al. 2010) into two snorm16 values per
+    /// vector, out[2i] and out[2i+1].  The unit sphere is projected onto an octahedron that
+    /// is unfolded into the [-1,1]^2 square, giving a 4 byte normal with an error below
+    /// 0.005 degrees.  Decoded vectors are normalized.  Strides allow reading from and
+    /// writing to the Normal member of a vertex array.
+    ///</summary>
+    static void EncodeOctahedral( const DirectX::XMFLOAT3* in, size_t inStrideInBytes, size_t count, std::int16_t* out );
+    static void DecodeOctahedral( const std::int16_t* in, size_t count, DirectX::XMFLOAT3* out, size_t outStrideInBytes );
+};
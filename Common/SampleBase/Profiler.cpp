@@ -0,0 +1,172 @@
+//***************************************************************************************
+// Profiler.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "Profiler.h"
+#include "Clock.h"
+#include "SnapshotRing.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+const std::uint32_t Profiler::EventsPerThread;
+
+std::atomic<bool> Profiler::sEnabled { false };
+
+namespace
+{
+    // Shortest span the time stamp counter is calibrated over.
+    const std::int64_t MinCalibrationNanoseconds = 10000000;
+
+    struct Event
+    {
+        const char*   Name;
+        std::uint64_t Begin;
+        std::uint64_t End;
+    };
+
+    struct ThreadBuffer
+    {
+        std::uint32_t ThreadIndex = 0;
+
+        // Events written by previous flushes, guarded by the flush mutex.
+        std::uint64_t Flushed = 0;
+
+        // Written by the owning thread only.
+        SnapshotRing<Event, Profiler::EventsPerThread> Events;
+    };
+
+    struct Registry
+    {
+        Registry()
+            : OriginTicks( Profiler::Timestamp() )
+            , OriginNanoseconds( Clock::Default().Now() )
+        {
+        }
+
+        // Mutex guards Buffers and is only held briefly, since a thread's first event
+        // waits for it.  FlushMutex serializes flushes.
+        std::mutex                                 Mutex;
+        std::mutex                                 FlushMutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> Buffers;
+
+        // Time stamp counter and clock at the same instant, the origin of trace times.
+        std::uint64_t OriginTicks;
+        std::int64_t  OriginNanoseconds;
+    };
+
+    Registry& GetRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    // Buffers are kept after their thread exits, so that its events can still be flushed.
+    thread_local ThreadBuffer* tBuffer = nullptr;
+
+    ThreadBuffer* RegisterThread()
+    {
+        Registry&                   registry = GetRegistry();
+        std::lock_guard<std::mutex> lock( registry.Mutex );
+
+        registry.Buffers.emplace_back( new ThreadBuffer );
+        ThreadBuffer* buffer = registry.Buffers.back().get();
+        buffer->ThreadIndex  = static_cast<std::uint32_t>( registry.Buffers.size() - 1 );
+        return buffer;
+    }
+
+    void WriteJsonString( std::ofstream& out, const char* s )
+    {
+        out << '"';
+        for ( ; *s; ++s )
+        {
+            if ( *s == '"' || *s == '\\' )
+                out << '\\' << *s;
+            else if ( static_cast<unsigned char>( *s ) < 0x20 )
+                out << ' ';
+            else
+                out << *s;
+        }
+        out << '"';
+    }
+} // namespace
+
+void Profiler::SetEnabled( bool enabled )
+{
+    // Sets the trace origin before the first event.
+    GetRegistry();
+    sEnabled.store( enabled, std::memory_order_relaxed );
+}
+
+void Profiler::Record( const char* name, std::uint64_t begin, std::uint64_t end )
+{
+    ThreadBuffer* buffer = tBuffer;
+    if ( !buffer )
+        buffer = tBuffer = RegisterThread();
+
+    buffer->Events.Push( { name, begin, end } );
+}
+
+bool Profiler::FlushChromeTrace( const char* path )
+{
+    Registry&                   registry = GetRegistry();
+    std::lock_guard<std::mutex> flushLock( registry.FlushMutex );
+
+    // Buffers are never freed, so they can be read after the registry is unlocked.
+    std::vector<ThreadBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock( registry.Mutex );
+        for ( const std::unique_ptr<ThreadBuffer>& buffer : registry.Buffers )
+            buffers.push_back( buffer.get() );
+    }
+
+    // Calibrate the time stamp counter against the clock over the time since the origin.
+    const Clock& clock = Clock::Default();
+    std::int64_t nanoseconds;
+    while ( ( nanoseconds = clock.Now() - registry.OriginNanoseconds ) < MinCalibrationNanoseconds )
+    {
+    }
+    double microsecondsPerTick = nanoseconds * 1e-3 / static_cast<double>( Timestamp() - registry.OriginTicks );
+
+    std::ofstream out( path, std::ios::out | std::ios::trunc );
+    if ( !out )
+        return false;
+
+    char number[64];
+    out << "{\"traceEvents\":[";
+
+    bool               first = true;
+    std::vector<Event> events;
+    for ( ThreadBuffer* buffer : buffers )
+    {
+        // Events the thread overwrote before or while they were copied are lost.
+        std::uint64_t end = buffer->Events.GetCount();
+        events.resize( static_cast<size_t>( std::min<std::uint64_t>( end - buffer->Flushed, EventsPerThread ) ) );
+        events.resize( static_cast<size_t>( buffer->Events.Copy( buffer->Flushed, end, events.data() ) ) );
+        buffer->Flushed = end;
+
+        std::snprintf( number, sizeof( number ), "%u", buffer->ThreadIndex );
+        out << ( first ? "\n" : ",\n" ) << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << number
+            << ",\"args\":{\"name\":\"Thread " << number << "\"}}";
+        first = false;
+
+        for ( const Event& e : events )
+        {
+            out << ",\n{\"name\":";
+            WriteJsonString( out, e.Name );
+
+            double ts  = static_cast<double>( static_cast<std::int64_t>( e.Begin - registry.OriginTicks ) ) * microsecondsPerTick;
+            double dur = static_cast<double>( e.End - e.Begin ) * microsecondsPerTick;
+            std::snprintf( number, sizeof( number ), "%u,\"ts\":%.3f,\"dur\":%.3f}", buffer->ThreadIndex, ts, dur );
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << number;
+        }
+    }
+
+    out << "\n]}\n";
+    return static_cast<bool>( out );
+}
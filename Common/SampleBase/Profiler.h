@@ -0,0 +1,91 @@
+//***************************************************************************************
+// Profiler.h
+//
+// Scoped CPU profiler with Chrome trace export.
+//
+//   void Sample::Update( const GameTimer& gt )
+//   {
+//       PROFILE_SCOPE( "Update" );
+//       ...
+//   }
+//
+// A scope reads the time stamp counter when it is entered and left, and appends one
+// (name, begin, end) event to a ring buffer owned by the calling thread: no locks, no
+// allocation and no shared cache lines.  The two counter reads dominate the cost, which
+// depends on the processor: in a virtual machine where one read took about 20 ns, a
+// scope measured 37 to 55 ns, well short of a 20 ns budget for the whole scope.  A
+// thread's buffer is created and registered on its first event, which briefly takes a
+// lock.  While capture is disabled a scope costs one relaxed atomic load.
+//
+// FlushChromeTrace writes the events recorded since the previous flush as Chrome
+// trace-event JSON, which chrome://tracing, Perfetto and Speedscope open.  A thread
+// that records more than EventsPerThread events between flushes overwrites its oldest
+// ones.  Names must outlive the flush, e.g. string literals.
+//
+// SampleBase toggles capture with F3 and writes profile.json when capture stops.  Define
+// PROFILER_DISABLED to compile the scopes out.
+//***************************************************************************************
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+class Profiler
+{
+public:
+    static const std::uint32_t EventsPerThread = 1 << 16;
+
+    // Starts or stops recording.  Disabled by default.
+    static void SetEnabled( bool enabled );
+    static bool IsEnabled() { return sEnabled.load( std::memory_order_relaxed ); }
+
+    // Time stamp counter ticks.
+    static std::uint64_t Timestamp() { return __rdtsc(); }
+
+    // Appends a completed scope to the calling thread's buffer.
+    static void Record( const char* name, std::uint64_t begin, std::uint64_t end );
+
+    ///<summary>
+    /// Writes the events recorded since the previous flush to a new trace file, with
+    /// timestamps in microseconds since the profiler was first used.  May be called from
+    /// any thread while others record.  Returns false if the file cannot be written.
+    ///</summary>
+    static bool FlushChromeTrace( const char* path );
+
+private:
+    static std::atomic<bool> sEnabled;
+};
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope( const char* name ) : mName( name ), mBegin( Profiler::IsEnabled() ? Profiler::Timestamp() : 0 ) {}
+    ProfileScope( const ProfileScope& rhs ) = delete;
+    ProfileScope& operator=( const ProfileScope& rhs ) = delete;
+
+    ~ProfileScope()
+    {
+        if ( mBegin != 0 )
+            Profiler::Record( mName, mBegin, Profiler::Timestamp() );
+    }
+
+private:
+    const char*   mName;
+    std::uint64_t mBegin;
+};
+
+#define PROFILE_CONCAT_INNER( a, b ) a##b
+#define PROFILE_CONCAT( a, b ) PROFILE_CONCAT_INNER( a, b )
+
+#if defined( PROFILER_DISABLED )
+#define PROFILE_SCOPE( name )
+#else
+#define PROFILE_SCOPE( name ) ProfileScope PROFILE_CONCAT( profileScope, __LINE__ )( name )
+#endif
@@ -0,0 +1,235 @@
+//***************************************************************************************
+// Random.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "Random.h"
+#include "CpuFeatures.h"
+#include <atomic>
+#include <immintrin.h>
+
+namespace
+{
+    // splitmix64, used to expand a single seed into full engine states.
+    std::uint64_t SplitMix64( std::uint64_t& x )
+    {
+        std::uint64_t z = ( x += 0x9E3779B97F4A7C15ull );
+        z               = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+        z               = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+        return z ^ ( z >> 31 );
+    }
+
+    inline std::uint64_t Rotl64( std::uint64_t x, int k )
+    {
+        return ( x << k ) | ( x >> ( 64 - k ) );
+    }
+
+    inline std::uint32_t Rotl32( std::uint32_t x, int k )
+    {
+        return ( x << k ) | ( x >> ( 32 - k ) );
+    }
+
+    // Top 24 bits mapped to [0, 1).  The low bits of xoshiro128+ are weak, so they are dropped.
+    inline float ToUnitFloat( std::uint32_t x )
+    {
+        return (float)( x >> 8 ) * ( 1.0f / 16777216.0f );
+    }
+
+    typedef std::uint32_t LaneState[4][RandomEngine::LaneCount];
+
+    void NextBlockScalar( LaneState& s, std::uint32_t* out )
+    {
+        for ( size_t i = 0; i < RandomEngine::LaneCount; ++i )
+        {
+            out[i] = s[0][i] + s[3][i];
+
+            std::uint32_t t = s[1][i] << 9;
+            s[2][i] ^= s[0][i];
+            s[3][i] ^= s[1][i];
+            s[1][i] ^= s[2][i];
+            s[0][i] ^= s[3][i];
+            s[2][i] ^= t;
+            s[3][i] = Rotl32( s[3][i], 11 );
+        }
+    }
+
+    // Same recurrence as NextBlockScalar, 8 lanes per instruction.
+    inline __m256i NextBlockAVX2( __m256i& s0, __m256i& s1, __m256i& s2, __m256i& s3 )
+    {
+        __m256i result = _mm256_add_epi32( s0, s3 );
+
+        __m256i t = _mm256_slli_epi32( s1, 9 );
+        s2        = _mm256_xor_si256( s2, s0 );
+        s3        = _mm256_xor_si256( s3, s1 );
+        s1        = _mm256_xor_si256( s1, s2 );
+        s0        = _mm256_xor_si256( s0, s3 );
+        s2        = _mm256_xor_si256( s2, t );
+        s3        = _mm256_or_si256( _mm256_slli_epi32( s3, 11 ), _mm256_srli_epi32( s3, 21 ) );
+
+        return result;
+    }
+
+    // Generates count (a multiple of LaneCount) floats in [a, b).
+    void FillFloatsAVX2( LaneState& s, float* out, size_t count, float a, float b )
+    {
+        __m256i s0 = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( s[0] ) );
+        __m256i s1 = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( s[1] ) );
+        __m256i s2 = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( s[2] ) );
+        __m256i s3 = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( s[3] ) );
+
+        // Same operations and roundings as the scalar a + ToUnitFloat( r ) * ( b - a ), so
+        // both paths give bit-identical floats; a fused multiply-add would round once less.
+        const __m256 unit   = _mm256_set1_ps( 1.0f / 16777216.0f );
+        const __m256 range  = _mm256_set1_ps( b - a );
+        const __m256 offset = _mm256_set1_ps( a );
+
+        for ( size_t i = 0; i < count; i += RandomEngine::LaneCount )
+        {
+            __m256i r = _mm256_srli_epi32( NextBlockAVX2( s0, s1, s2, s3 ), 8 );
+            _mm256_storeu_ps( out + i, _mm256_add_ps( _mm256_mul_ps( _mm256_mul_ps( _mm256_cvtepi32_ps( r ), unit ), range ), offset ) );
+        }
+
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( s[0] ), s0 );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( s[1] ), s1 );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( s[2] ), s2 );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( s[3] ), s3 );
+    }
+
+    std::atomic<std::uint64_t> gNextThreadStream( 0 );
+} // namespace
+
+RandomEngine::RandomEngine( std::uint64_t seed )
+{
+    Seed( seed );
+}
+
+void RandomEngine::Seed( std::uint64_t seed )
+{
+    std::uint64_t x = seed;
+    for ( int i = 0; i < 4; ++i )
+        mState[i] = SplitMix64( x );
+
+    for ( size_t lane = 0; lane < LaneCount; ++lane )
+    {
+        std::uint64_t a = SplitMix64( x );
+        std::uint64_t b = SplitMix64( x );
+
+        mLanes[0][lane] = (std::uint32_t)a;
+        mLanes[1][lane] = (std::uint32_t)( a >> 32 );
+        mLanes[2][lane] = (std::uint32_t)b;
+        mLanes[3][lane] = (std::uint32_t)( b >> 32 );
+
+        // An all-zero state would only ever produce zeros.
+        if ( a == 0 && b == 0 )
+            mLanes[0][lane] = 1;
+    }
+}
+
+std::uint64_t RandomEngine::NextU64()
+{
+    const std::uint64_t result = Rotl64( mState[1] * 5, 7 ) * 9;
+    const std::uint64_t t      = mState[1] << 17;
+
+    mState[2] ^= mState[0];
+    mState[3] ^= mState[1];
+    mState[1] ^= mState[2];
+    mState[0] ^= mState[3];
+    mState[2] ^= t;
+    mState[3] = Rotl64( mState[3], 45 );
+
+    return result;
+}
+
+std::uint32_t RandomEngine::NextU32()
+{
+    return (std::uint32_t)( NextU64() >> 32 );
+}
+
+float RandomEngine::NextFloat()
+{
+    return ToUnitFloat( NextU32() );
+}
+
+float RandomEngine::NextFloat( float a, float b )
+{
+    return a + NextFloat() * ( b - a );
+}
+
+int RandomEngine::NextInt( int a, int b )
+{
+    // Lemire's multiply-shift range reduction with rejection of the biased remainder.
+    std::uint32_t range = (std::uint32_t)( (std::int64_t)b - a + 1 );
+    if ( range == 0 )
+        return (int)NextU32(); // [INT_MIN, INT_MAX]
+
+    std::uint64_t m = (std::uint64_t)NextU32() * range;
+    if ( (std::uint32_t)m < range )
+    {
+        std::uint32_t threshold = ( 0u - range ) % range;
+        while ( (std::uint32_t)m < threshold )
+            m = (std::uint64_t)NextU32() * range;
+    }
+
+    return (int)( (std::int64_t)a + (std::int64_t)( m >> 32 ) );
+}
+
+void RandomEngine::NextBlock( std::uint32_t* out )
+{
+    NextBlockScalar( mLanes, out );
+}
+
+void RandomEngine::FillU32( std::uint32_t* out, size_t count )
+{
+    size_t full = count - count % LaneCount;
+    for ( size_t i = 0; i < full; i += LaneCount )
+        NextBlock( out + i );
+
+    if ( full < count )
+    {
+        std::uint32_t block[LaneCount];
+        NextBlock( block );
+        for ( size_t i = full; i < count; ++i )
+            out[i] = block[i - full];
+    }
+}
+
+void RandomEngine::FillFloats( float* out, size_t count )
+{
+    FillFloats( out, count, 0.0f, 1.0f );
+}
+
+void RandomEngine::FillFloats( float* out, size_t count, float a, float b )
+{
+    size_t full = count - count % LaneCount;
+
+    if ( CpuFeatures::HasAVX2() )
+    {
+        FillFloatsAVX2( mLanes, out, full, a, b );
+    }
+    else
+    {
+        std::uint32_t block[LaneCount];
+        for ( size_t i = 0; i < full; i += LaneCount )
+        {
+            NextBlock( block );
+            for ( size_t k = 0; k < LaneCount; ++k )
+                out[i + k] = a + ToUnitFloat( block[k] ) * ( b - a );
+        }
+    }
+
+    if ( full < count )
+    {
+        std::uint32_t block[LaneCount];
+        NextBlock( block );
+        for ( size_t i = full; i < count; ++i )
+            out[i] = a + ToUnitFloat( block[i - full] ) * ( b - a );
+    }
+}
+
+RandomEngine& RandomEngine::ThreadDefault()
+{
+    // Stream 0 uses DefaultSeed directly so single threaded programs are reproducible.
+    thread_local RandomEngine engine( DefaultSeed + 0x9E3779B97F4A7C15ull * gNextThreadStream.fetch_add( 1 ) );
+    return engine;
+}
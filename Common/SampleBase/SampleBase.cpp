@@ -4,6 +4,7 @@
 #include "stdafx.h"
 
 #include "SampleBase.h"
+#include "Profiler.h"
 #include <WindowsX.h>
 
 using Microsoft::WRL::ComPtr;
@@ -75,9 +76,45 @@ int SampleBase::Run()
 
             if (!mAppPaused)
             {
+                PROFILE_SCOPE("SampleBase::Frame");
+
                 CalculateFrameStats();
-                Update(mTimer);
-                Draw(mTimer);
+                UpdateDynamicResolution();
+
+                std::int64_t frameStart = mTimer.GetClock().Now();
+                mFenceWaitNanoseconds   = 0;
+
+                if (mFixedTimestepEnabled)
+                {
+                    int steps = mFixedTimestep.Advance(mTimer.DeltaNanoseconds());
+                    for (int i = 0; i < steps; ++i)
+                    {
+                        PROFILE_SCOPE("FixedUpdate");
+                        FixedUpdate(mTimer, mFixedTimestep.GetStepSeconds());
+                    }
+                    {
+                        PROFILE_SCOPE("Update");
+                        Update(mTimer);
+                    }
+                    {
+                        PROFILE_SCOPE("Draw");
+                        DrawInterpolated(mTimer, mFixedTimestep.GetAlpha());
+                    }
+                }
+                else
+                {
+                    {
+                        PROFILE_SCOPE("Update");
+                        Update(mTimer);
+                    }
+                    {
+                        PROFILE_SCOPE("Draw");
+                        Draw(mTimer);
+                    }
+                }
+
+                std::int64_t cpuNanoseconds = mTimer.GetClock().Now() - frameStart - mFenceWaitNanoseconds;
+                mMeasuredFrameTimes.SetCpuMs(static_cast<float>(1000.0 * cpuNanoseconds / Clock::NanosecondsPerSecond));
             }
             else
             {
@@ -92,6 +129,8 @@ int SampleBase::Run()
 
 bool SampleBase::Initialize()
 {
+    PROFILE_SCOPE("SampleBase::Initialize");
+
     if (!InitMainWindow())
         return false;
 
@@ -349,6 +388,14 @@ LRESULT SampleBase::MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
             }
             else if ((int)wParam == VK_F2)
                 Set4xMsaaState(!m4xMsaaState);
+            else if ((int)wParam == VK_F3)
+            {
+                // Toggle CPU profiling; stopping writes the capture to profile.json.
+                bool enable = !Profiler::IsEnabled();
+                Profiler::SetEnabled(enable);
+                if (!enable)
+                    Profiler::FlushChromeTrace("profile.json");
+            }
 
             return 0;
     }
@@ -552,6 +599,8 @@ void SampleBase::FlushCommandQueue()
     // Wait until the GPU has completed commands up to this fence point.
     if (mFence->GetCompletedValue() < mCurrentFence)
     {
+        std::int64_t waitStart = mTimer.GetClock().Now();
+
         HANDLE eventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
 
         // Fire event when GPU hits current fence.
@@ -560,6 +609,8 @@ void SampleBase::FlushCommandQueue()
         // Wait until the GPU hits current fence event is fired.
         WaitForSingleObject(eventHandle, INFINITE);
         CloseHandle(eventHandle);
+
+        mFenceWaitNanoseconds += mTimer.GetClock().Now() - waitStart;
     }
 }
 
@@ -578,32 +629,44 @@ D3D12_CPU_DESCRIPTOR_HANDLE SampleBase::DepthStencilView() const
 
 void SampleBase::CalculateFrameStats()
 {
-    // Code computes the average frames per second, and also the
-    // average time it takes to render one frame.  These stats
-    // are appended to the window caption bar.
+    // Records the last frame's times, and once per second appends the average frame
+    // rate and time, the 99th percentile frame time and the 1% low frame rate to the
+    // window caption bar.
 
-    static int   frameCnt    = 0;
-    static float timeElapsed = 0.0f;
+    FrameTimes  times = mFrameTimeSource->GetFrameTimes();
+    FrameSample sample;
+    sample.FrameMs = static_cast<float>(1000.0 * mTimer.DeltaTimeDouble());
+    sample.CpuMs   = times.CpuMs;
+    sample.GpuMs   = times.GpuMs;
 
-    frameCnt++;
-
-    // Compute averages over one second period.
-    if ((mTimer.TotalTime() - timeElapsed) >= 1.0f)
+    if (mFrameStats.AddFrame(mTimer.TotalTimeDouble(), sample))
     {
-        float fps  = (float)frameCnt; // fps = frameCnt / 1
-        float mspf = 1000.0f / fps;
+        const FrameStatsReport& report = mFrameStats.GetLastReport();
+
+        wchar_t windowText[256];
+        swprintf_s(windowText, L"%s    fps: %.1f   mspf: %.2f   p99: %.2f ms   1%% low: %.1f fps", mMainWndCaption.c_str(),
+                   report.AverageFps, report.Frame.Mean, report.Frame.P99, report.OnePercentLow);
 
-        wstring fpsStr  = to_wstring(fps);
-        wstring mspfStr = to_wstring(mspf);
+        SetWindowText(mhMainWnd, windowText);
+    }
+}
 
-        wstring windowText = mMainWndCaption + L"    fps: " + fpsStr + L"   mspf: " + mspfStr;
+void SampleBase::UpdateDynamicResolution()
+{
+    if (!mDynamicResolutionEnabled)
+        return;
 
-        SetWindowText(mhMainWnd, windowText.c_str());
+    mDynamicResolution.Update(*mFrameTimeSource);
 
-        // Reset for next average.
-        frameCnt = 0;
-        timeElapsed += 1.0f;
-    }
+    int width  = mDynamicResolution.GetScaledSize(mClientWidth);
+    int height = mDynamicResolution.GetScaledSize(mClientHeight);
+
+    mScreenViewport.TopLeftX = 0;
+    mScreenViewport.TopLeftY = 0;
+    mScreenViewport.Width    = static_cast<float>(width);
+    mScreenViewport.Height   = static_cast<float>(height);
+
+    mScissorRect = {0, 0, width, height};
 }
 
 void SampleBase::LogAdapters()
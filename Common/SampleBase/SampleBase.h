@@ -9,6 +9,9 @@
 #include <crtdbg.h>
 #endif
 
+#include "DynamicResolution.h"
+#include "FixedTimestep.h"
+#include "FrameStatistics.h"
 #include "GameTimer.h"
 #include "d3dUtil.h"
 
@@ -48,6 +51,13 @@ protected:
     virtual void Draw(const GameTimer& gt)   = 0;
     virtual void OnDestory()                 = 0;
 
+    // Fixed timestep hooks, used when mFixedTimestepEnabled is set.  Each frame, FixedUpdate
+    // runs once per elapsed simulation step of dt seconds, then Update runs once for
+    // per-frame work such as input and the camera, then DrawInterpolated renders with
+    // alpha in [0, 1), the position between the previous and the current simulation state.
+    virtual void FixedUpdate(const GameTimer& gt, float dt) {}
+    virtual void DrawInterpolated(const GameTimer& gt, float alpha) { Draw(gt); }
+
     // Convenience overrides for handling mouse input.
     virtual void OnMouseDown(WPARAM btnState, int x, int y) {}
     virtual void OnMouseUp(WPARAM btnState, int x, int y) {}
@@ -67,6 +77,10 @@ protected:
 
     void CalculateFrameStats();
 
+    // Feeds the last frame's times to the dynamic resolution controller and scales
+    // mScreenViewport and mScissorRect to the resulting render size.
+    void UpdateDynamicResolution();
+
     void LogAdapters();
     void LogAdapterOutputs(IDXGIAdapter* adapter);
     void LogOutputDisplayModes(IDXGIOutput* output, DXGI_FORMAT format);
@@ -89,6 +103,10 @@ protected:
     // Used to keep track of the delta-time and game time (4.4).
     GameTimer mTimer;
 
+    // Frame time history and per-second percentiles, see CalculateFrameStats.  Call
+    // mFrameStats.OpenCsv/OpenJson to log every second to a file.
+    FrameStatistics mFrameStats;
+
     Microsoft::WRL::ComPtr<IDXGIFactory4>   mdxgiFactory;
     Microsoft::WRL::ComPtr<IDXGISwapChain3> m_pSwapChain;
     Microsoft::WRL::ComPtr<ID3D12Device>    md3dDevice;
@@ -96,6 +114,10 @@ protected:
     Microsoft::WRL::ComPtr<ID3D12Fence> mFence;
     UINT64                              mCurrentFence = 0;
 
+    // Time FlushCommandQueue spent waiting for the GPU during the current frame, which
+    // is not counted as CPU time.
+    std::int64_t mFenceWaitNanoseconds = 0;
+
     Microsoft::WRL::ComPtr<ID3D12CommandQueue>        m_pCommandQueue;
     Microsoft::WRL::ComPtr<ID3D12CommandAllocator>    m_pDirectCmdListAlloc;
     Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> m_pCommandList;
@@ -112,6 +134,21 @@ protected:
     D3D12_VIEWPORT mScreenViewport;
     D3D12_RECT     mScissorRect;
 
+    // Fixed timestep simulation, off by default (see FixedUpdate).
+    bool          mFixedTimestepEnabled = false;
+    FixedTimestep mFixedTimestep;
+
+    // Dynamic resolution, off by default.  When enabled, mScreenViewport and mScissorRect
+    // cover the scaled render area at the top left of the render targets, and the sample
+    // upscales that area to the client area.  After each frame Run sets the CPU time of
+    // Update and Draw, less any wait in FlushCommandQueue, in mMeasuredFrameTimes and
+    // keeps its GPU time.  Samples with timestamp queries set the GPU time there with
+    // SetGpuMs, or point mFrameTimeSource somewhere else; without it the scale holds.
+    bool                  mDynamicResolutionEnabled = false;
+    DynamicResolution     mDynamicResolution;
+    ManualFrameTimeSource mMeasuredFrameTimes;
+    FrameTimeSource*      mFrameTimeSource = &mMeasuredFrameTimes;
+
     UINT m_iRtvDescriptorSize     = 0;
     UINT mDsvDescriptorSize       = 0;
     UINT mCbvSrvUavDescriptorSize = 0;
@@ -0,0 +1,328 @@
+//***************************************************************************************
+// SimdMath.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "SimdMath.h"
+#include "CpuFeatures.h"
+#include <immintrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+    //
+    // Thin wrappers so each function is written once for both vector widths.
+    //
+
+    struct SseOps
+    {
+        typedef __m128  F;
+        typedef __m128i I;
+        static const size_t Width = 4;
+
+        static F Load( const float* p ) { return _mm_loadu_ps( p ); }
+        static void Store( float* p, F v ) { _mm_storeu_ps( p, v ); }
+        static F Set( float a ) { return _mm_set1_ps( a ); }
+        static F Add( F a, F b ) { return _mm_add_ps( a, b ); }
+        static F Sub( F a, F b ) { return _mm_sub_ps( a, b ); }
+        static F Mul( F a, F b ) { return _mm_mul_ps( a, b ); }
+        static F MulAdd( F a, F b, F c ) { return _mm_add_ps( _mm_mul_ps( a, b ), c ); }
+        static F Div( F a, F b ) { return _mm_div_ps( a, b ); }
+        static F Sqrt( F a ) { return _mm_sqrt_ps( a ); }
+        static F Min( F a, F b ) { return _mm_min_ps( a, b ); }
+        static F Max( F a, F b ) { return _mm_max_ps( a, b ); }
+        static F And( F a, F b ) { return _mm_and_ps( a, b ); }
+        static F AndNot( F a, F b ) { return _mm_andnot_ps( a, b ); }
+        static F Or( F a, F b ) { return _mm_or_ps( a, b ); }
+        static F Xor( F a, F b ) { return _mm_xor_ps( a, b ); }
+        static F Greater( F a, F b ) { return _mm_cmpgt_ps( a, b ); }
+        static F Less( F a, F b ) { return _mm_cmplt_ps( a, b ); }
+        static F Select( F mask, F a, F b ) { return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) ); }
+
+        static I Truncate( F a ) { return _mm_cvttps_epi32( a ); }
+        static F ToFloat( I a ) { return _mm_cvtepi32_ps( a ); }
+        static F AsFloat( I a ) { return _mm_castsi128_ps( a ); }
+        static I SetI( int a ) { return _mm_set1_epi32( a ); }
+        static I AddI( I a, I b ) { return _mm_add_epi32( a, b ); }
+        static I AndI( I a, I b ) { return _mm_and_si128( a, b ); }
+        static I EqualI( I a, I b ) { return _mm_cmpeq_epi32( a, b ); }
+        template <int N>
+        static I ShiftLeftI( I a ) { return _mm_slli_epi32( a, N ); }
+    };
+
+    struct AvxOps
+    {
+        typedef __m256  F;
+        typedef __m256i I;
+        static const size_t Width = 8;
+
+        static F Load( const float* p ) { return _mm256_loadu_ps( p ); }
+        static void Store( float* p, F v ) { _mm256_storeu_ps( p, v ); }
+        static F Set( float a ) { return _mm256_set1_ps( a ); }
+        static F Add( F a, F b ) { return _mm256_add_ps( a, b ); }
+        static F Sub( F a, F b ) { return _mm256_sub_ps( a, b ); }
+        static F Mul( F a, F b ) { return _mm256_mul_ps( a, b ); }
+        static F MulAdd( F a, F b, F c ) { return _mm256_fmadd_ps( a, b, c ); }
+        static F Div( F a, F b ) { return _mm256_div_ps( a, b ); }
+        static F Sqrt( F a ) { return _mm256_sqrt_ps( a ); }
+        static F Min( F a, F b ) { return _mm256_min_ps( a, b ); }
+        static F Max( F a, F b ) { return _mm256_max_ps( a, b ); }
+        static F And( F a, F b ) { return _mm256_and_ps( a, b ); }
+        static F AndNot( F a, F b ) { return _mm256_andnot_ps( a, b ); }
+        static F Or( F a, F b ) { return _mm256_or_ps( a, b ); }
+        static F Xor( F a, F b ) { return _mm256_xor_ps( a, b ); }
+        static F Greater( F a, F b ) { return _mm256_cmp_ps( a, b, _CMP_GT_OQ ); }
+        static F Less( F a, F b ) { return _mm256_cmp_ps( a, b, _CMP_LT_OQ ); }
+        static F Select( F mask, F a, F b ) { return _mm256_blendv_ps( b, a, mask ); }
+
+        static I Truncate( F a ) { return _mm256_cvttps_epi32( a ); }
+        static F ToFloat( I a ) { return _mm256_cvtepi32_ps( a ); }
+        static F AsFloat( I a ) { return _mm256_castsi256_ps( a ); }
+        static I SetI( int a ) { return _mm256_set1_epi32( a ); }
+        static I AddI( I a, I b ) { return _mm256_add_epi32( a, b ); }
+        static I AndI( I a, I b ) { return _mm256_and_si256( a, b ); }
+        static I EqualI( I a, I b ) { return _mm256_cmpeq_epi32( a, b ); }
+        template <int N>
+        static I ShiftLeftI( I a ) { return _mm256_slli_epi32( a, N ); }
+    };
+
+    const float Pi     = 3.14159265358979f;
+    const float PiDiv2 = 1.57079632679490f;
+    const float PiDiv4 = 0.78539816339745f;
+
+    template <class S>
+    typename S::F SignBits( typename S::F a )
+    {
+        return S::And( a, S::Set( -0.0f ) );
+    }
+
+    template <class S>
+    typename S::F Abs( typename S::F a )
+    {
+        return S::AndNot( S::Set( -0.0f ), a );
+    }
+
+    template <class S>
+    void SinCosT( typename S::F x, typename S::F& s, typename S::F& c )
+    {
+        typedef typename S::F F;
+        typedef typename S::I I;
+
+        F sign = SignBits<S>( x );
+        F ax   = Abs<S>( x );
+
+        // Octant index rounded up to even, so r = ax - j*pi/4 lies in [-pi/4, pi/4].
+        I j = S::Truncate( S::Mul( ax, S::Set( 1.27323954473516f ) ) );
+        j   = S::AndI( S::AddI( j, S::SetI( 1 ) ), S::SetI( ~1 ) );
+        F y = S::ToFloat( j );
+
+        // pi/4 split in three parts (Cody-Waite) to keep the reduction exact.
+        F r = S::MulAdd( y, S::Set( -0.78515625f ), ax );
+        r   = S::MulAdd( y, S::Set( -2.4187564849853515625e-4f ), r );
+        r   = S::MulAdd( y, S::Set( -3.77489497744594108e-8f ), r );
+        F z = S::Mul( r, r );
+
+        F ps = S::MulAdd( S::Set( -1.9515295891e-4f ), z, S::Set( 8.3321608736e-3f ) );
+        ps   = S::MulAdd( ps, z, S::Set( -1.6666654611e-1f ) );
+        ps   = S::MulAdd( S::Mul( ps, z ), r, r );
+
+        F pc = S::MulAdd( S::Set( 2.443315711809948e-5f ), z, S::Set( -1.388731625493765e-3f ) );
+        pc   = S::MulAdd( pc, z, S::Set( 4.166664568298827e-2f ) );
+        pc   = S::MulAdd( S::Mul( pc, z ), z, S::MulAdd( z, S::Set( -0.5f ), S::Set( 1.0f ) ) );
+
+        // Quadrants 1 and 3 swap the polynomials; sin is negated in quadrants 2 and 3,
+        // cos in quadrants 1 and 2.
+        F swap    = S::AsFloat( S::EqualI( S::AndI( j, S::SetI( 2 ) ), S::SetI( 2 ) ) );
+        F sinSign = S::Xor( sign, S::AsFloat( S::template ShiftLeftI<29>( S::AndI( j, S::SetI( 4 ) ) ) ) );
+        F cosSign = S::AsFloat( S::template ShiftLeftI<29>( S::AndI( S::AddI( j, S::SetI( 2 ) ), S::SetI( 4 ) ) ) );
+
+        s = S::Xor( S::Select( swap, pc, ps ), sinSign );
+        c = S::Xor( S::Select( swap, ps, pc ), cosSign );
+    }
+
+    template <class S>
+    typename S::F ATan2T( typename S::F y, typename S::F x )
+    {
+        typedef typename S::F F;
+
+        F ax = Abs<S>( x );
+        F ay = Abs<S>( y );
+        F mx = S::Max( ax, ay );
+        F mn = S::Min( ax, ay );
+
+        // t = atan argument in [0, 1]; 0/0 gives 0.
+        F t = S::And( S::Div( mn, mx ), S::Greater( mx, S::Set( 0.0f ) ) );
+
+        // Reduce to |r| <= tan(pi/8).
+        F big = S::Greater( t, S::Set( 0.414213562373095f ) );
+        F r   = S::Select( big, S::Div( S::Sub( t, S::Set( 1.0f ) ), S::Add( t, S::Set( 1.0f ) ) ), t );
+        F z   = S::Mul( r, r );
+
+        F p = S::MulAdd( S::Set( 8.05374449538e-2f ), z, S::Set( -1.38776856032e-1f ) );
+        p   = S::MulAdd( p, z, S::Set( 1.99777106478e-1f ) );
+        p   = S::MulAdd( p, z, S::Set( -3.33329491539e-1f ) );
+        p   = S::MulAdd( S::Mul( p, z ), r, r );
+        p   = S::Add( p, S::And( big, S::Set( PiDiv4 ) ) );
+
+        p = S::Select( S::Greater( ay, ax ), S::Sub( S::Set( PiDiv2 ), p ), p );
+        p = S::Select( S::Less( x, S::Set( 0.0f ) ), S::Sub( S::Set( Pi ), p ), p );
+        return S::Or( p, SignBits<S>( y ) );
+    }
+
+    template <class S>
+    typename S::F ACosT( typename S::F x )
+    {
+        typedef typename S::F F;
+
+        x = S::Min( S::Max( x, S::Set( -1.0f ) ), S::Set( 1.0f ) );
+
+        F sign = SignBits<S>( x );
+        F ax   = Abs<S>( x );
+
+        // For |x| > 0.5 evaluate asin at sqrt((1 - |x|)/2) using acos(x) = 2 asin(sqrt((1 - x)/2)).
+        F big = S::Greater( ax, S::Set( 0.5f ) );
+        F z   = S::Select( big, S::Mul( S::Sub( S::Set( 1.0f ), ax ), S::Set( 0.5f ) ), S::Mul( ax, ax ) );
+        F t   = S::Select( big, S::Sqrt( z ), ax );
+
+        F p = S::MulAdd( S::Set( 4.2163199048e-2f ), z, S::Set( 2.4181311049e-2f ) );
+        p   = S::MulAdd( p, z, S::Set( 4.5470025998e-2f ) );
+        p   = S::MulAdd( p, z, S::Set( 7.4953002686e-2f ) );
+        p   = S::MulAdd( p, z, S::Set( 1.6666752422e-1f ) );
+        p   = S::MulAdd( S::Mul( p, z ), t, t );
+        p   = S::Or( p, sign );
+
+        // big:   x > 0 -> 2p,  x < 0 -> pi - 2|p|.
+        // small: pi/2 - asin(x).
+        F piIfNegative = S::And( S::Less( x, S::Set( 0.0f ) ), S::Set( Pi ) );
+        F bigResult    = S::MulAdd( p, S::Set( 2.0f ), piIfNegative );
+        F smallResult  = S::Sub( S::Set( PiDiv2 ), p );
+        return S::Select( big, bigResult, smallResult );
+    }
+
+    //
+    // Array loops.  They return the number of elements processed; the caller runs the
+    // remainder through the 4-wide kernel on a zero padded copy.
+    //
+
+    template <class S>
+    size_t SinCosArray( const float* x, float* s, float* c, size_t count )
+    {
+        size_t full = count - count % S::Width;
+        for ( size_t i = 0; i < full; i += S::Width )
+        {
+            typename S::F vs, vc;
+            SinCosT<S>( S::Load( x + i ), vs, vc );
+            S::Store( s + i, vs );
+            S::Store( c + i, vc );
+        }
+        return full;
+    }
+
+    template <class S>
+    size_t ATan2Array( const float* y, const float* x, float* out, size_t count )
+    {
+        size_t full = count - count % S::Width;
+        for ( size_t i = 0; i < full; i += S::Width )
+            S::Store( out + i, ATan2T<S>( S::Load( y + i ), S::Load( x + i ) ) );
+        return full;
+    }
+
+    template <class S>
+    size_t ACosArray( const float* x, float* out, size_t count )
+    {
+        size_t full = count - count % S::Width;
+        for ( size_t i = 0; i < full; i += S::Width )
+            S::Store( out + i, ACosT<S>( S::Load( x + i ) ) );
+        return full;
+    }
+
+    struct KernelTable
+    {
+        size_t ( *SinCos )( const float*, float*, float*, size_t );
+        size_t ( *ATan2 )( const float*, const float*, float*, size_t );
+        size_t ( *ACos )( const float*, float*, size_t );
+    };
+
+    const KernelTable& GetKernels()
+    {
+        static const KernelTable kernels =
+            CpuFeatures::HasAVX2() ? KernelTable { SinCosArray<AvxOps>, ATan2Array<AvxOps>, ACosArray<AvxOps> } :
+                                     KernelTable { SinCosArray<SseOps>, ATan2Array<SseOps>, ACosArray<SseOps> };
+        return kernels;
+    }
+
+    // Copies the remaining (< 8) elements into a zero padded block of 4-wide vectors.
+    struct TailBlock
+    {
+        alignas( 16 ) float v[8];
+
+        TailBlock( const float* src, size_t n )
+        {
+            for ( size_t i = 0; i < 8; ++i )
+                v[i] = i < n ? src[i] : 0.0f;
+        }
+    };
+} // namespace
+
+void XM_CALLCONV SimdMath::SinCos( FXMVECTOR x, XMVECTOR* s, XMVECTOR* c )
+{
+    SinCosT<SseOps>( x, *s, *c );
+}
+
+XMVECTOR XM_CALLCONV SimdMath::ATan2( FXMVECTOR y, FXMVECTOR x )
+{
+    return ATan2T<SseOps>( y, x );
+}
+
+XMVECTOR XM_CALLCONV SimdMath::ACos( FXMVECTOR x )
+{
+    return ACosT<SseOps>( x );
+}
+
+void SimdMath::SinCos( const float* x, float* s, float* c, size_t count )
+{
+    size_t done = GetKernels().SinCos( x, s, c, count );
+    if ( done == count )
+        return;
+
+    size_t    n = count - done;
+    TailBlock tx( x + done, n );
+    float     ts[8], tc[8];
+    SinCosArray<SseOps>( tx.v, ts, tc, 8 );
+    for ( size_t i = 0; i < n; ++i )
+    {
+        s[done + i] = ts[i];
+        c[done + i] = tc[i];
+    }
+}
+
+void SimdMath::ATan2( const float* y, const float* x, float* out, size_t count )
+{
+    size_t done = GetKernels().ATan2( y, x, out, count );
+    if ( done == count )
+        return;
+
+    size_t    n = count - done;
+    TailBlock ty( y + done, n );
+    TailBlock tx( x + done, n );
+    float     t[8];
+    ATan2Array<SseOps>( ty.v, tx.v, t, 8 );
+    for ( size_t i = 0; i < n; ++i )
+        out[done + i] = t[i];
+}
+
+void SimdMath::ACos( const float* x, float* out, size_t count )
+{
+    size_t done = GetKernels().ACos( x, out, count );
+    if ( done == count )
+        return;
+
+    size_t    n = count - done;
+    TailBlock tx( x + done, n );
+    float     t[8];
+    ACosArray<SseOps>( tx.v, t, 8 );
+    for ( size_t i = 0; i < n; ++i )
+        out[done + i] = t[i];
+}
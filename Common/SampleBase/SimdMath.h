@@ -0,0 +1,42 @@
+//***************************************************************************************
+// SimdMath.h
+//
+// Vectorized transcendental functions.
+//
+// Minimax polynomial approximations (after Cephes) evaluated 4 lanes at a time with
+// SSE2 or 8 lanes at a time with AVX2/FMA, selected at runtime.  Maximum errors below
+// were measured against double precision libm over the stated domains:
+//
+//   SinCos  |x| <= 8192        sin, cos: 2 ulp, or 1e-7 absolute near the zeros
+//   ATan2   all finite inputs  3.5 ulp
+//   ACos    [-1, 1]            1.5 ulp
+//
+// Accuracy of SinCos degrades gracefully beyond |x| = 8192 as the three-part pi/4
+// range reduction runs out of bits; keep angles reduced for large arguments.
+// ATan2(0, 0) returns 0.  ACos of inputs outside [-1, 1] is clamped.
+//***************************************************************************************
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+
+class SimdMath
+{
+public:
+    //
+    // 4-wide versions on XMVECTOR.
+    //
+
+    static void XM_CALLCONV     SinCos( DirectX::FXMVECTOR x, DirectX::XMVECTOR* s, DirectX::XMVECTOR* c );
+    static DirectX::XMVECTOR XM_CALLCONV ATan2( DirectX::FXMVECTOR y, DirectX::FXMVECTOR x );
+    static DirectX::XMVECTOR XM_CALLCONV ACos( DirectX::FXMVECTOR x );
+
+    //
+    // Array versions.  Outputs may alias inputs.
+    //
+
+    static void SinCos( const float* x, float* s, float* c, size_t count );
+    static void ATan2( const float* y, const float* x, float* out, size_t count );
+    static void ACos( const float* x, float* out, size_t count );
+};
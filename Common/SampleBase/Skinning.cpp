@@ -0,0 +1,232 @@
+//***************************************************************************************
+// Skinning.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "Skinning.h"
+#include "CpuFeatures.h"
+#include <immintrin.h>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // Vertices per thread pool task.
+    const size_t GrainSize = 4096;
+
+    // Rigid bone transform as a unit dual quaternion: rotation Real and Dual = 0.5 * t * Real.
+    struct DualQuat
+    {
+        XMFLOAT4 Real;
+        XMFLOAT4 Dual;
+    };
+
+    DualQuat ToDualQuat( const Affine3x4& bone )
+    {
+        XMVECTOR scale, rotation, translation;
+        XMMatrixDecompose( &scale, &rotation, &translation, bone.Load() );
+
+        // XMQuaternionMultiply( a, b ) is the Hamilton product b * a.
+        DualQuat dq;
+        XMStoreFloat4( &dq.Real, rotation );
+        XMStoreFloat4( &dq.Dual, XMVectorScale( XMQuaternionMultiply( rotation, XMVectorSetW( translation, 0.0f ) ), 0.5f ) );
+        return dq;
+    }
+
+    template <typename T>
+    inline T* Element( T* base, size_t index, size_t strideInBytes )
+    {
+        return reinterpret_cast<T*>( reinterpret_cast<BYTE*>( base ) + index * strideInBytes );
+    }
+
+    //
+    // Blend the weighted bones of one vertex.
+    //
+
+    struct BlendedMatrix
+    {
+        XMVECTOR R0, R1, R2;
+    };
+
+    struct BlendedDualQuat
+    {
+        XMVECTOR Real, Dual;
+    };
+
+    BlendedMatrix BlendMatricesSSE( const Affine3x4* bones, const SkinInfluences& v )
+    {
+        BlendedMatrix m = { XMVectorZero(), XMVectorZero(), XMVectorZero() };
+        for ( int k = 0; k < 4; ++k )
+        {
+            if ( v.Weights[k] == 0.0f )
+                continue;
+
+            const Affine3x4& b = bones[v.Bones[k]];
+            XMVECTOR         w = XMVectorReplicate( v.Weights[k] );
+            m.R0               = XMVectorMultiplyAdd( w, XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( b.m[0] ) ), m.R0 );
+            m.R1               = XMVectorMultiplyAdd( w, XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( b.m[1] ) ), m.R1 );
+            m.R2               = XMVectorMultiplyAdd( w, XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( b.m[2] ) ), m.R2 );
+        }
+        return m;
+    }
+
+    BlendedMatrix BlendMatricesAVX2( const Affine3x4* bones, const SkinInfluences& v )
+    {
+        // Rows 0-1 of each bone in one 256-bit register, row 2 in a 128-bit one.
+        __m256 r01 = _mm256_setzero_ps();
+        __m128 r2  = _mm_setzero_ps();
+        for ( int k = 0; k < 4; ++k )
+        {
+            if ( v.Weights[k] == 0.0f )
+                continue;
+
+            const Affine3x4& b = bones[v.Bones[k]];
+            r01                = _mm256_fmadd_ps( _mm256_set1_ps( v.Weights[k] ), _mm256_loadu_ps( b.m[0] ), r01 );
+            r2                 = _mm_fmadd_ps( _mm_set1_ps( v.Weights[k] ), _mm_loadu_ps( b.m[2] ), r2 );
+        }
+
+        BlendedMatrix m = { _mm256_castps256_ps128( r01 ), _mm256_extractf128_ps( r01, 1 ), r2 };
+        return m;
+    }
+
+    // Signs are chosen relative to the first influence so all bones blend along the shorter arc.
+    BlendedDualQuat BlendDualQuatsSSE( const DualQuat* bones, const SkinInfluences& v )
+    {
+        XMVECTOR pivot = XMLoadFloat4( &bones[v.Bones[0]].Real );
+
+        BlendedDualQuat q = { XMVectorZero(), XMVectorZero() };
+        for ( int k = 0; k < 4; ++k )
+        {
+            if ( v.Weights[k] == 0.0f )
+                continue;
+
+            const DualQuat& b    = bones[v.Bones[k]];
+            XMVECTOR        real = XMLoadFloat4( &b.Real );
+            float           w    = XMVectorGetX( XMVector4Dot( real, pivot ) ) < 0.0f ? -v.Weights[k] : v.Weights[k];
+
+            q.Real = XMVectorMultiplyAdd( XMVectorReplicate( w ), real, q.Real );
+            q.Dual = XMVectorMultiplyAdd( XMVectorReplicate( w ), XMLoadFloat4( &b.Dual ), q.Dual );
+        }
+        return q;
+    }
+
+    BlendedDualQuat BlendDualQuatsAVX2( const DualQuat* bones, const SkinInfluences& v )
+    {
+        __m128 pivot = _mm_loadu_ps( &bones[v.Bones[0]].Real.x );
+
+        __m256 acc = _mm256_setzero_ps();
+        for ( int k = 0; k < 4; ++k )
+        {
+            if ( v.Weights[k] == 0.0f )
+                continue;
+
+            __m256 dq = _mm256_loadu_ps( &bones[v.Bones[k]].Real.x );
+            float  w  = _mm_cvtss_f32( _mm_dp_ps( _mm256_castps256_ps128( dq ), pivot, 0xF1 ) ) < 0.0f ? -v.Weights[k] : v.Weights[k];
+            acc       = _mm256_fmadd_ps( _mm256_set1_ps( w ), dq, acc );
+        }
+
+        BlendedDualQuat q = { _mm256_castps256_ps128( acc ), _mm256_extractf128_ps( acc, 1 ) };
+        return q;
+    }
+
+    //
+    // Apply the blended transform to one vertex.
+    //
+
+    void WriteVertex( const BlendedMatrix& m, const SkinnedVertexStreams& in, const SkinnedVertexStreams& out, size_t i )
+    {
+        XMVECTOR p = XMVectorSetW( XMLoadFloat3( Element( in.Position, i, in.StrideInBytes ) ), 1.0f );
+        XMStoreFloat3( Element( out.Position, i, out.StrideInBytes ),
+                       XMVectorSet( XMVectorGetX( XMVector4Dot( m.R0, p ) ),
+                                    XMVectorGetX( XMVector4Dot( m.R1, p ) ),
+                                    XMVectorGetX( XMVector4Dot( m.R2, p ) ), 0.0f ) );
+
+        auto transformDirection = [&]( XMFLOAT3* src, XMFLOAT3* dst ) {
+            XMVECTOR v = XMLoadFloat3( Element( src, i, in.StrideInBytes ) );
+            v          = XMVectorSet( XMVectorGetX( XMVector3Dot( m.R0, v ) ),
+                                      XMVectorGetX( XMVector3Dot( m.R1, v ) ),
+                                      XMVectorGetX( XMVector3Dot( m.R2, v ) ), 0.0f );
+            XMStoreFloat3( Element( dst, i, out.StrideInBytes ), XMVector3Normalize( v ) );
+        };
+
+        if ( in.Normal && out.Normal )
+            transformDirection( in.Normal, out.Normal );
+        if ( in.Tangent && out.Tangent )
+            transformDirection( in.Tangent, out.Tangent );
+    }
+
+    void WriteVertex( const BlendedDualQuat& dq, const SkinnedVertexStreams& in, const SkinnedVertexStreams& out, size_t i )
+    {
+        // Normalize by the length of the real part, which makes the blend a rigid transform again.
+        XMVECTOR invLen = XMVectorReciprocal( XMVector4Length( dq.Real ) );
+        XMVECTOR real   = XMVectorMultiply( dq.Real, invLen );
+        XMVECTOR dual   = XMVectorMultiply( dq.Dual, invLen );
+
+        // t = 2 * Dual * conjugate( Real ).
+        XMVECTOR t = XMVectorScale( XMQuaternionMultiply( XMQuaternionConjugate( real ), dual ), 2.0f );
+
+        XMVECTOR p = XMLoadFloat3( Element( in.Position, i, in.StrideInBytes ) );
+        XMStoreFloat3( Element( out.Position, i, out.StrideInBytes ), XMVectorAdd( XMVector3Rotate( p, real ), t ) );
+
+        if ( in.Normal && out.Normal )
+        {
+            XMVECTOR n = XMLoadFloat3( Element( in.Normal, i, in.StrideInBytes ) );
+            XMStoreFloat3( Element( out.Normal, i, out.StrideInBytes ), XMVector3Normalize( XMVector3Rotate( n, real ) ) );
+        }
+        if ( in.Tangent && out.Tangent )
+        {
+            XMVECTOR v = XMLoadFloat3( Element( in.Tangent, i, in.StrideInBytes ) );
+            XMStoreFloat3( Element( out.Tangent, i, out.StrideInBytes ), XMVector3Normalize( XMVector3Rotate( v, real ) ) );
+        }
+    }
+} // namespace
+
+SkinnedVertexStreams SkinnedVertexStreams::FromVertices( GeometryGenerator::Vertex* vertices )
+{
+    SkinnedVertexStreams streams;
+    streams.Position      = &vertices->Position;
+    streams.Normal        = &vertices->Normal;
+    streams.Tangent       = &vertices->TangentU;
+    streams.StrideInBytes = sizeof( GeometryGenerator::Vertex );
+    return streams;
+}
+
+void Skinning::Skin( Mode                        mode,
+                     const Affine3x4*            bones,
+                     size_t                      boneCount,
+                     const SkinInfluences*       influences,
+                     size_t                      vertexCount,
+                     const SkinnedVertexStreams& bindPose,
+                     const SkinnedVertexStreams& out,
+                     ThreadPool&                 pool )
+{
+    const bool avx2 = CpuFeatures::HasAVX2();
+
+    if ( mode == Mode::LinearBlend )
+    {
+        pool.ParallelFor( vertexCount, GrainSize, [&]( size_t begin, size_t end ) {
+            for ( size_t i = begin; i < end; ++i )
+            {
+                BlendedMatrix m = avx2 ? BlendMatricesAVX2( bones, influences[i] ) : BlendMatricesSSE( bones, influences[i] );
+                WriteVertex( m, bindPose, out, i );
+            }
+        } );
+    }
+    else
+    {
+        std::vector<DualQuat> dualQuats( boneCount );
+        for ( size_t b = 0; b < boneCount; ++b )
+            dualQuats[b] = ToDualQuat( bones[b] );
+
+        const DualQuat* dq = dualQuats.data();
+        pool.ParallelFor( vertexCount, GrainSize, [&]( size_t begin, size_t end ) {
+            for ( size_t i = begin; i < end; ++i )
+            {
+                BlendedDualQuat q = avx2 ? BlendDualQuatsAVX2( dq, influences[i] ) : BlendDualQuatsSSE( dq, influences[i] );
+                WriteVertex( q, bindPose, out, i );
+            }
+        } );
+    }
+}
@@ -0,0 +1,66 @@
+//***************************************************************************************
+// Skinning.h
+//
+// CPU vertex skinning.
+//
+// Deforms position/normal/tangent streams by up to 4 weighted bones per vertex, either
+// with linear blend skinning (blend the bone matrices) or dual quaternion skinning
+// (Kavan et al. 2007, blend rigid transforms as dual quaternions, which avoids the
+// "candy wrapper" collapse of LBS at twisted joints).  Serves as a reference for GPU
+// skinning, as a fallback when there is no GPU budget left, and to get deformed
+// geometry for picking or physics.
+//
+// Vertices are split across the thread pool; bone blending uses AVX2/FMA when the CPU
+// supports it.
+//
+// Bone transforms are skin matrices, i.e. inverse bind pose * bone world.  Dual
+// quaternion mode ignores any scale in them.  Normals and tangents are transformed by
+// the blended matrix and renormalized, which is exact for rotation + uniform scale.
+//***************************************************************************************
+
+#pragma once
+
+#include "Affine3x4.h"
+#include "GeometryGenerator.h"
+#include "ThreadPool.h"
+#include <cstdint>
+
+// Bone indices and weights of one vertex.  Weights should sum to 1; unused slots have
+// weight 0.
+struct SkinInfluences
+{
+    std::uint16_t Bones[4];
+    float         Weights[4];
+};
+
+// Strided views of the vertex attributes to read or write.  Normal and Tangent may be
+// null to skip them.
+struct SkinnedVertexStreams
+{
+    DirectX::XMFLOAT3* Position      = nullptr;
+    DirectX::XMFLOAT3* Normal        = nullptr;
+    DirectX::XMFLOAT3* Tangent       = nullptr;
+    size_t             StrideInBytes = sizeof( DirectX::XMFLOAT3 );
+
+    static SkinnedVertexStreams FromVertices( GeometryGenerator::Vertex* vertices );
+};
+
+class Skinning
+{
+public:
+    enum class Mode
+    {
+        LinearBlend,
+        DualQuaternion
+    };
+
+    // Skins vertexCount vertices from bindPose into out.  The two may not overlap.
+    static void Skin( Mode                        mode,
+                      const Affine3x4*            bones,
+                      size_t                      boneCount,
+                      const SkinInfluences*       influences,
+                      size_t                      vertexCount,
+                      const SkinnedVertexStreams& bindPose,
+                      const SkinnedVertexStreams& out,
+                      ThreadPool&                 pool = ThreadPool::Default() );
+};
@@ -0,0 +1,65 @@
+//***************************************************************************************
+// SnapshotRing.h
+//
+// Fixed ring of the last Size values pushed by one thread, which any thread can copy
+// from without locks.
+//
+// The writer stores a value into slot count % Size and then publishes count + 1.
+// Readers copy the slots they want and then reload the count: while the count reads
+// n, the writer may already be overwriting the slot of entry n, which is also the slot
+// of entry n - Size, so every entry older than n + 1 - Size may have changed during the
+// copy and is dropped from it.
+//***************************************************************************************
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+template <typename T, std::uint32_t Size>
+class SnapshotRing
+{
+public:
+    // Writer thread only.
+    void Push( const T& value )
+    {
+        // Publish the value before the count that makes it visible to readers.
+        std::uint64_t count   = mCount.load( std::memory_order_relaxed );
+        mValues[count % Size] = value;
+        mCount.store( count + 1, std::memory_order_release );
+    }
+
+    // Number of values ever pushed.
+    std::uint64_t GetCount() const { return mCount.load( std::memory_order_acquire ); }
+
+    ///<summary>
+    /// Copies the entries with indices in [first, last) that are still in the ring, oldest
+    /// first, and returns how many were copied.  last must not exceed GetCount(), and out
+    /// must have room for min( last - first, Size ) values.  The copied entries are always
+    /// the newest ones before last.
+    ///</summary>
+    std::uint64_t Copy( std::uint64_t first, std::uint64_t last, T* out ) const
+    {
+        std::uint64_t begin = std::max<std::uint64_t>( first, last > Size ? last - Size : 0 );
+        std::uint64_t count = last - begin;
+
+        for ( std::uint64_t i = begin; i < last; ++i )
+            out[i - begin] = mValues[i % Size];
+
+        std::atomic_thread_fence( std::memory_order_acquire );
+        std::uint64_t newEnd = mCount.load( std::memory_order_relaxed );
+        if ( newEnd + 1 - begin > Size )
+        {
+            std::uint64_t overwritten = std::min<std::uint64_t>( newEnd + 1 - begin - Size, count );
+            std::copy( out + overwritten, out + count, out );
+            count -= overwritten;
+        }
+
+        return count;
+    }
+
+private:
+    T                          mValues[Size];
+    std::atomic<std::uint64_t> mCount { 0 };
+};
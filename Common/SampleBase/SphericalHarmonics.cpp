@@ -0,0 +1,376 @@
+//***************************************************************************************
+// SphericalHarmonics.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "SphericalHarmonics.h"
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+using namespace DirectX;
+
+namespace
+{
+    // Normalization constants of the real basis functions.
+    const float Y00 = 0.282094792f; // 1 / (2 sqrt(pi))
+    const float Y1  = 0.488602512f; // sqrt(3) / (2 sqrt(pi))
+    const float Y2  = 1.092548431f; // sqrt(15) / (2 sqrt(pi))
+    const float Y20 = 0.315391565f; // sqrt(5) / (4 sqrt(pi))
+    const float Y22 = 0.546274215f; // sqrt(15) / (4 sqrt(pi))
+
+    // Band of each coefficient index.
+    const int CoefficientBand[SHColor::MaxCoefficients] = { 0, 1, 1, 1, 2, 2, 2, 2, 2 };
+
+    // Evaluates the 9 basis functions for 4 directions at once (SoA).
+    void XM_CALLCONV EvalBasis4( FXMVECTOR x, FXMVECTOR y, FXMVECTOR z, XMVECTOR basis[SHColor::MaxCoefficients] )
+    {
+        basis[0] = XMVectorReplicate( Y00 );
+        basis[1] = XMVectorScale( y, Y1 );
+        basis[2] = XMVectorScale( z, Y1 );
+        basis[3] = XMVectorScale( x, Y1 );
+        basis[4] = XMVectorScale( XMVectorMultiply( x, y ), Y2 );
+        basis[5] = XMVectorScale( XMVectorMultiply( y, z ), Y2 );
+        basis[6] = XMVectorScale( XMVectorSubtract( XMVectorScale( XMVectorMultiply( z, z ), 3.0f ), g_XMOne ), Y20 );
+        basis[7] = XMVectorScale( XMVectorMultiply( x, z ), Y2 );
+        basis[8] = XMVectorScale( XMVectorNegativeMultiplySubtract( y, y, XMVectorMultiply( x, x ) ), Y22 );
+    }
+
+    //
+    // Cubemap face frames: dir = Major + u * U + v * V for u, v in [-1, 1], with u
+    // increasing to the right and v increasing downwards in the D3D face layout.
+    //
+
+    struct CubeFaceFrame
+    {
+        XMFLOAT3 Major;
+        XMFLOAT3 U;
+        XMFLOAT3 V;
+    };
+
+    const CubeFaceFrame FaceFrames[6] =
+    {
+        { {  1.0f,  0.0f,  0.0f }, {  0.0f, 0.0f, -1.0f }, { 0.0f, -1.0f,  0.0f } }, // +X
+        { { -1.0f,  0.0f,  0.0f }, {  0.0f, 0.0f,  1.0f }, { 0.0f, -1.0f,  0.0f } }, // -X
+        { {  0.0f,  1.0f,  0.0f }, {  1.0f, 0.0f,  0.0f }, { 0.0f,  0.0f,  1.0f } }, // +Y
+        { {  0.0f, -1.0f,  0.0f }, {  1.0f, 0.0f,  0.0f }, { 0.0f,  0.0f, -1.0f } }, // -Y
+        { {  0.0f,  0.0f,  1.0f }, {  1.0f, 0.0f,  0.0f }, { 0.0f, -1.0f,  0.0f } }, // +Z
+        { {  0.0f,  0.0f, -1.0f }, { -1.0f, 0.0f,  0.0f }, { 0.0f, -1.0f,  0.0f } }, // -Z
+    };
+
+    // Projects one face.  Rows are processed 4 texels at a time: basis values are
+    // computed in SoA form and accumulated against the transposed texel colors, so each
+    // coefficient keeps separate red, green and blue accumulators of 4 partial sums.
+    void ProjectFace( const XMFLOAT4* texels, int size, const CubeFaceFrame& frame, SHColor& sh, float& totalWeight )
+    {
+        XMVECTOR sumR[SHColor::MaxCoefficients];
+        XMVECTOR sumG[SHColor::MaxCoefficients];
+        XMVECTOR sumB[SHColor::MaxCoefficients];
+        for ( int i = 0; i < SHColor::MaxCoefficients; ++i )
+            sumR[i] = sumG[i] = sumB[i] = XMVectorZero();
+        XMVECTOR sumWeight = XMVectorZero();
+
+        const float    texelSize  = 2.0f / size;
+        const XMVECTOR laneOffset = XMVectorSet( 0.5f, 1.5f, 2.5f, 3.5f );
+        const XMVECTOR laneIndex  = XMVectorSet( 0.0f, 1.0f, 2.0f, 3.0f );
+
+        for ( int row = 0; row < size; ++row )
+        {
+            float v = ( row + 0.5f ) * texelSize - 1.0f;
+
+            const XMFLOAT4* rowTexels = texels + static_cast<size_t>( row ) * size;
+            for ( int col = 0; col < size; col += 4 )
+            {
+                XMVECTOR u = XMVectorSubtract( XMVectorScale( XMVectorAdd( XMVectorReplicate( float( col ) ), laneOffset ), texelSize ), g_XMOne );
+
+                // Unnormalized direction, then the texel solid angle texelSize^2 / |dir|^3.
+                XMVECTOR x = XMVectorMultiplyAdd( u, XMVectorReplicate( frame.U.x ), XMVectorReplicate( frame.Major.x + v * frame.V.x ) );
+                XMVECTOR y = XMVectorMultiplyAdd( u, XMVectorReplicate( frame.U.y ), XMVectorReplicate( frame.Major.y + v * frame.V.y ) );
+                XMVECTOR z = XMVectorMultiplyAdd( u, XMVectorReplicate( frame.U.z ), XMVectorReplicate( frame.Major.z + v * frame.V.z ) );
+
+                XMVECTOR invLength = XMVectorReciprocalSqrt( XMVectorMultiplyAdd( u, u, XMVectorReplicate( 1.0f + v * v ) ) );
+                XMVECTOR weight    = XMVectorScale( XMVectorMultiply( invLength, XMVectorMultiply( invLength, invLength ) ), texelSize * texelSize );
+
+                x = XMVectorMultiply( x, invLength );
+                y = XMVectorMultiply( y, invLength );
+                z = XMVectorMultiply( z, invLength );
+
+                // Load 4 texels, zero-padding past the end of the row.
+                XMMATRIX colors;
+                if ( col + 4 <= size )
+                {
+                    colors = XMMATRIX( XMLoadFloat4( &rowTexels[col] ), XMLoadFloat4( &rowTexels[col + 1] ),
+                                       XMLoadFloat4( &rowTexels[col + 2] ), XMLoadFloat4( &rowTexels[col + 3] ) );
+                }
+                else
+                {
+                    XMFLOAT4 tail[4] = {};
+                    for ( int k = 0; col + k < size; ++k )
+                        tail[k] = rowTexels[col + k];
+                    colors = XMMATRIX( XMLoadFloat4( &tail[0] ), XMLoadFloat4( &tail[1] ),
+                                       XMLoadFloat4( &tail[2] ), XMLoadFloat4( &tail[3] ) );
+
+                    XMVECTOR valid = XMVectorLess( laneIndex, XMVectorReplicate( float( size - col ) ) );
+                    weight         = XMVectorAndInt( weight, valid );
+                }
+                colors = XMMatrixTranspose( colors );
+
+                XMVECTOR r = XMVectorMultiply( colors.r[0], weight );
+                XMVECTOR g = XMVectorMultiply( colors.r[1], weight );
+                XMVECTOR b = XMVectorMultiply( colors.r[2], weight );
+
+                XMVECTOR basis[SHColor::MaxCoefficients];
+                EvalBasis4( x, y, z, basis );
+                for ( int i = 0; i < SHColor::MaxCoefficients; ++i )
+                {
+                    sumR[i] = XMVectorMultiplyAdd( basis[i], r, sumR[i] );
+                    sumG[i] = XMVectorMultiplyAdd( basis[i], g, sumG[i] );
+                    sumB[i] = XMVectorMultiplyAdd( basis[i], b, sumB[i] );
+                }
+                sumWeight = XMVectorAdd( sumWeight, weight );
+            }
+        }
+
+        // Reduce the 4 lanes of each accumulator: transposing (R, G, B, 0) puts the lanes
+        // in rows, and the sum of the rows is the RGB coefficient.
+        for ( int i = 0; i < SHColor::MaxCoefficients; ++i )
+        {
+            XMMATRIX lanes = XMMatrixTranspose( XMMATRIX( sumR[i], sumG[i], sumB[i], XMVectorZero() ) );
+            XMStoreFloat4A( &sh.C[i], XMVectorAdd( XMVectorAdd( lanes.r[0], lanes.r[1] ), XMVectorAdd( lanes.r[2], lanes.r[3] ) ) );
+        }
+        totalWeight = XMVectorGetX( XMVector4Dot( sumWeight, g_XMOne ) );
+    }
+
+    //
+    // Rotation.  Band l is rotated independently of the others: the rotated function is
+    // evaluated at 2l+1 fixed sample directions, and solving for the band's coefficients
+    // that reproduce those values gives the rotated coefficients.  The inverse basis
+    // matrices of the sample directions are computed once.
+    //
+
+    // Inverts the n x n row-major matrix a in place (Gauss-Jordan with partial pivoting).
+    void Invert( float* a, int n )
+    {
+        float inverse[25];
+        assert( n <= 5 );
+        for ( int r = 0; r < n; ++r )
+            for ( int c = 0; c < n; ++c )
+                inverse[r * n + c] = r == c ? 1.0f : 0.0f;
+
+        for ( int c = 0; c < n; ++c )
+        {
+            int pivot = c;
+            for ( int r = c + 1; r < n; ++r )
+                if ( std::fabs( a[r * n + c] ) > std::fabs( a[pivot * n + c] ) )
+                    pivot = r;
+            assert( a[pivot * n + c] != 0.0f );
+
+            for ( int k = 0; k < n; ++k )
+            {
+                std::swap( a[c * n + k], a[pivot * n + k] );
+                std::swap( inverse[c * n + k], inverse[pivot * n + k] );
+            }
+
+            float scale = 1.0f / a[c * n + c];
+            for ( int k = 0; k < n; ++k )
+            {
+                a[c * n + k] *= scale;
+                inverse[c * n + k] *= scale;
+            }
+
+            for ( int r = 0; r < n; ++r )
+            {
+                if ( r == c )
+                    continue;
+                float f = a[r * n + c];
+                for ( int k = 0; k < n; ++k )
+                {
+                    a[r * n + k] -= f * a[c * n + k];
+                    inverse[r * n + k] -= f * inverse[c * n + k];
+                }
+            }
+        }
+
+        for ( int i = 0; i < n * n; ++i )
+            a[i] = inverse[i];
+    }
+
+    struct BandRotationSamples
+    {
+        int      First; // index of the band's first coefficient
+        int      Count; // 2l+1
+        XMFLOAT3 Directions[5];
+        float    InverseBasis[5][5]; // [coefficient][sample]
+    };
+
+    BandRotationSamples MakeBandRotationSamples( int band, const XMFLOAT3* directions )
+    {
+        BandRotationSamples s;
+        s.First = band * band;
+        s.Count = 2 * band + 1;
+
+        float a[25];
+        for ( int k = 0; k < s.Count; ++k )
+        {
+            XMStoreFloat3( &s.Directions[k], XMVector3Normalize( XMLoadFloat3( &directions[k] ) ) );
+
+            float basis[SHColor::MaxCoefficients];
+            SphericalHarmonics::EvalBasis( XMLoadFloat3( &s.Directions[k] ), basis );
+            for ( int m = 0; m < s.Count; ++m )
+                a[k * s.Count + m] = basis[s.First + m];
+        }
+
+        Invert( a, s.Count );
+        for ( int m = 0; m < s.Count; ++m )
+            for ( int k = 0; k < s.Count; ++k )
+                s.InverseBasis[m][k] = a[m * s.Count + k];
+        return s;
+    }
+
+    const BandRotationSamples& GetBandRotationSamples( int band )
+    {
+        static const XMFLOAT3 band1Directions[3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+        static const XMFLOAT3 band2Directions[5] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 0.0f },
+                                                     { 1.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 1.0f } };
+
+        static const BandRotationSamples samples[2] = { MakeBandRotationSamples( 1, band1Directions ),
+                                                        MakeBandRotationSamples( 2, band2Directions ) };
+        assert( band == 1 || band == 2 );
+        return samples[band - 1];
+    }
+} // namespace
+
+void XM_CALLCONV SphericalHarmonics::EvalBasis( FXMVECTOR dir, float basis[SHColor::MaxCoefficients] )
+{
+    XMFLOAT3 d;
+    XMStoreFloat3( &d, dir );
+
+    basis[0] = Y00;
+    basis[1] = Y1 * d.y;
+    basis[2] = Y1 * d.z;
+    basis[3] = Y1 * d.x;
+    basis[4] = Y2 * d.x * d.y;
+    basis[5] = Y2 * d.y * d.z;
+    basis[6] = Y20 * ( 3.0f * d.z * d.z - 1.0f );
+    basis[7] = Y2 * d.x * d.z;
+    basis[8] = Y22 * ( d.x * d.x - d.y * d.y );
+}
+
+XMVECTOR XM_CALLCONV SphericalHarmonics::Evaluate( const SHColor& sh, FXMVECTOR dir, int order )
+{
+    assert( order == 2 || order == 3 );
+
+    float basis[SHColor::MaxCoefficients];
+    EvalBasis( dir, basis );
+
+    XMVECTOR result = XMVectorZero();
+    for ( int i = 0; i < CoefficientCount( order ); ++i )
+        result = XMVectorMultiplyAdd( XMLoadFloat4A( &sh.C[i] ), XMVectorReplicate( basis[i] ), result );
+    return result;
+}
+
+void XM_CALLCONV SphericalHarmonics::AddSample( SHColor& sh, FXMVECTOR dir, FXMVECTOR color, float weight, int order )
+{
+    assert( order == 2 || order == 3 );
+
+    float basis[SHColor::MaxCoefficients];
+    EvalBasis( dir, basis );
+
+    XMVECTOR weighted = XMVectorScale( color, weight );
+    for ( int i = 0; i < CoefficientCount( order ); ++i )
+        XMStoreFloat4A( &sh.C[i], XMVectorMultiplyAdd( weighted, XMVectorReplicate( basis[i] ), XMLoadFloat4A( &sh.C[i] ) ) );
+}
+
+SHColor SphericalHarmonics::ProjectCubemap( const XMFLOAT4* const faces[6], int size, int order, ThreadPool& pool )
+{
+    assert( order == 2 || order == 3 );
+    assert( size > 0 );
+
+    SHColor faceSH[6];
+    float   faceWeight[6];
+    pool.ParallelFor( 6, 1, [&]( size_t begin, size_t end ) {
+        for ( size_t f = begin; f < end; ++f )
+            ProjectFace( faces[f], size, FaceFrames[f], faceSH[f], faceWeight[f] );
+    } );
+
+    // The texel solid angles only approximate the sphere's 4pi, so normalize by their sum.
+    float totalWeight = 0.0f;
+    for ( int f = 0; f < 6; ++f )
+        totalWeight += faceWeight[f];
+    XMVECTOR normalization = XMVectorReplicate( 4.0f * XM_PI / totalWeight );
+
+    SHColor sh;
+    for ( int i = 0; i < CoefficientCount( order ); ++i )
+    {
+        XMVECTOR sum = XMVectorZero();
+        for ( int f = 0; f < 6; ++f )
+            sum = XMVectorAdd( sum, XMLoadFloat4A( &faceSH[f].C[i] ) );
+        XMStoreFloat4A( &sh.C[i], XMVectorMultiply( sum, normalization ) );
+    }
+    return sh;
+}
+
+SHColor SphericalHarmonics::ConvolveIrradiance( const SHColor& sh )
+{
+    // Zonal coefficients of the clamped cosine, scaled by sqrt(4pi / (2l+1)) (Ramamoorthi
+    // and Hanrahan 2001).
+    const float bandScale[3] = { XM_PI, 2.0f * XM_PI / 3.0f, XM_PI / 4.0f };
+
+    SHColor result;
+    for ( int i = 0; i < SHColor::MaxCoefficients; ++i )
+        XMStoreFloat4A( &result.C[i], XMVectorScale( XMLoadFloat4A( &sh.C[i] ), bandScale[CoefficientBand[i]] ) );
+    return result;
+}
+
+SHColor SphericalHarmonics::Rotate( const SHColor& sh, CXMMATRIX R, int order )
+{
+    assert( order == 2 || order == 3 );
+
+    // f'(n) = f(n * R^-1), and R^-1 = R^T for a rotation.
+    XMMATRIX inverseR = XMMatrixTranspose( R );
+
+    SHColor result;
+    result.C[0] = sh.C[0];
+
+    for ( int band = 1; band < order; ++band )
+    {
+        const BandRotationSamples& s = GetBandRotationSamples( band );
+
+        // Values of the rotated band at the sample directions.
+        XMVECTOR values[5];
+        for ( int k = 0; k < s.Count; ++k )
+        {
+            float basis[SHColor::MaxCoefficients];
+            EvalBasis( XMVector3TransformNormal( XMLoadFloat3( &s.Directions[k] ), inverseR ), basis );
+
+            values[k] = XMVectorZero();
+            for ( int m = 0; m < s.Count; ++m )
+                values[k] = XMVectorMultiplyAdd( XMLoadFloat4A( &sh.C[s.First + m] ), XMVectorReplicate( basis[s.First + m] ), values[k] );
+        }
+
+        for ( int m = 0; m < s.Count; ++m )
+        {
+            XMVECTOR c = XMVectorZero();
+            for ( int k = 0; k < s.Count; ++k )
+                c = XMVectorMultiplyAdd( values[k], XMVectorReplicate( s.InverseBasis[m][k] ), c );
+            XMStoreFloat4A( &result.C[s.First + m], c );
+        }
+    }
+
+    return result;
+}
+
+SHColor SphericalHarmonics::ApplyWindow( const SHColor& sh, float width )
+{
+    assert( width > 0.0f );
+
+    float bandScale[3];
+    for ( int band = 0; band < 3; ++band )
+        bandScale[band] = band < width ? 0.5f * ( 1.0f + std::cos( XM_PI * band / width ) ) : 0.0f;
+
+    SHColor result;
+    for ( int i = 0; i < SHColor::MaxCoefficients; ++i )
+        XMStoreFloat4A( &result.C[i], XMVectorScale( XMLoadFloat4A( &sh.C[i] ), bandScale[CoefficientBand[i]] ) );
+    return result;
+}
@@ -0,0 +1,64 @@
+//***************************************************************************************
+// SphericalHarmonics.h
+//
+// Real spherical harmonics of order 2 (4 coefficients) and order 3 (9 coefficients)
+// for RGB lighting.
+//
+// Typical use for diffuse ambient light: project a cubemap or a set of lights into SH,
+// convolve to irradiance, optionally window to remove ringing, and upload the 9 RGB
+// coefficients per probe in place of an irradiance cubemap.  Evaluate in the shader
+// with the same basis as EvalBasis and multiply by albedo / pi.
+//
+// Directions are in the same space as the data (world space for probes) and must be
+// normalized.  Cubemap faces use the D3D layout and order +X, -X, +Y, -Y, +Z, -Z.
+//***************************************************************************************
+
+#pragma once
+
+#include "ThreadPool.h"
+#include <DirectXMath.h>
+
+// RGB coefficients, indexed l*(l+1) + m.  w is unused and keeps the rows aligned for SIMD.
+struct SHColor
+{
+    static const int MaxCoefficients = 9;
+
+    DirectX::XMFLOAT4A C[MaxCoefficients] = {};
+};
+
+class SphericalHarmonics
+{
+public:
+    // Number of coefficients used by an order (bands 0 .. order-1).
+    static int CoefficientCount( int order ) { return order * order; }
+
+    // Writes the 9 basis function values for dir to basis.
+    static void XM_CALLCONV EvalBasis( DirectX::FXMVECTOR dir, float basis[SHColor::MaxCoefficients] );
+
+    // Reconstructs the RGB value in direction dir.
+    static DirectX::XMVECTOR XM_CALLCONV Evaluate( const SHColor& sh, DirectX::FXMVECTOR dir, int order = 3 );
+
+    // Adds weight * color in direction dir, e.g. a directional light (a delta function)
+    // or one Monte Carlo sample of a radiance function with weight 4pi/N.
+    static void XM_CALLCONV AddSample( SHColor& sh, DirectX::FXMVECTOR dir, DirectX::FXMVECTOR color, float weight, int order = 3 );
+
+    ///<summary>
+    /// Projects a cubemap of linear RGB radiance (size x size RGBA float texels per face)
+    /// into SH.  Each texel is weighted by its solid angle, and the faces are processed
+    /// in parallel on the thread pool.
+    ///</summary>
+    static SHColor ProjectCubemap( const DirectX::XMFLOAT4* const faces[6], int size, int order = 3,
+                                   ThreadPool& pool = ThreadPool::Default() );
+
+    // Convolves radiance with the clamped cosine lobe, giving irradiance E(n).  Diffuse
+    // reflected radiance is then albedo / pi * E(n).
+    static SHColor ConvolveIrradiance( const SHColor& sh );
+
+    // Returns the coefficients of the function rotated by R, i.e. f'(n * R) = f(n).
+    static SHColor Rotate( const SHColor& sh, DirectX::CXMMATRIX R, int order = 3 );
+
+    // Scales band l by the Hanning window (1 + cos(pi*l/width)) / 2 (Sloan 2008) to
+    // reduce ringing.  width must be greater than the highest band used; larger widths
+    // remove less ringing and blur less.
+    static SHColor ApplyWindow( const SHColor& sh, float width );
+};
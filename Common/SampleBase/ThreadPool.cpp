@@ -0,0 +1,130 @@
+//***************************************************************************************
+// ThreadPool.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "ThreadPool.h"
+
+namespace
+{
+    // Set while a thread executes loop chunks, so nested loops run inline instead of
+    // waiting on the pool they are running on.
+    thread_local bool tInsideLoop = false;
+} // namespace
+
+ThreadPool::ThreadPool( unsigned workerCount )
+{
+    if ( workerCount == 0 )
+    {
+        unsigned hardwareThreads = std::thread::hardware_concurrency();
+        workerCount              = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    mWorkers.reserve( workerCount );
+    for ( unsigned i = 0; i < workerCount; ++i )
+        mWorkers.emplace_back( &ThreadPool::WorkerLoop, this );
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mQuit = true;
+    }
+    mWake.notify_all();
+
+    for ( std::thread& worker : mWorkers )
+        worker.join();
+}
+
+unsigned ThreadPool::GetThreadCount() const
+{
+    return (unsigned)mWorkers.size() + 1;
+}
+
+void ThreadPool::ParallelFor( size_t count, size_t grainSize, const std::function<void( size_t, size_t )>& body )
+{
+    if ( count == 0 )
+        return;
+
+    if ( grainSize == 0 )
+        grainSize = 1;
+
+    if ( count <= grainSize || mWorkers.empty() || tInsideLoop )
+    {
+        body( 0, count );
+        return;
+    }
+
+    std::lock_guard<std::mutex> submitLock( mSubmitMutex );
+
+    Job job;
+    job.Body       = &body;
+    job.Count      = count;
+    job.GrainSize  = grainSize;
+    job.ChunkCount = ( count + grainSize - 1 ) / grainSize;
+
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mJob = &job;
+        ++mGeneration;
+    }
+    mWake.notify_all();
+
+    RunChunks( job );
+
+    // All chunks have been claimed.  Unpublish the job and wait for the workers still
+    // executing one, since job lives on this stack frame.
+    std::unique_lock<std::mutex> lock( mMutex );
+    mJob = nullptr;
+    mDone.wait( lock, [this] { return mBusyWorkers == 0; } );
+}
+
+ThreadPool& ThreadPool::Default()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    std::uint64_t seenGeneration = 0;
+
+    std::unique_lock<std::mutex> lock( mMutex );
+    for ( ;; )
+    {
+        mWake.wait( lock, [&] { return mQuit || ( mJob != nullptr && mGeneration != seenGeneration ); } );
+        if ( mQuit )
+            return;
+
+        seenGeneration = mGeneration;
+        Job* job       = mJob;
+        ++mBusyWorkers;
+
+        lock.unlock();
+        RunChunks( *job );
+        lock.lock();
+
+        if ( --mBusyWorkers == 0 )
+            mDone.notify_all();
+    }
+}
+
+void ThreadPool::RunChunks( Job& job )
+{
+    tInsideLoop = true;
+
+    for ( ;; )
+    {
+        size_t chunk = job.NextChunk.fetch_add( 1 );
+        if ( chunk >= job.ChunkCount )
+            break;
+
+        size_t begin = chunk * job.GrainSize;
+        size_t end   = begin + job.GrainSize < job.Count ? begin + job.GrainSize : job.Count;
+        ( *job.Body )( begin, end );
+    }
+
+    tInsideLoop = false;
+}
@@ -0,0 +1,69 @@
+//***************************************************************************************
+// ThreadPool.h
+//
+// Minimal fork-join thread pool for data-parallel loops.
+//
+// ParallelFor splits [0, count) into chunks of grainSize elements and runs them on the
+// worker threads and the calling thread, returning once all chunks are done.  Loops
+// are run one at a time; a ParallelFor issued from inside a loop body, or with a
+// single chunk, runs inline on the calling thread.  The body must not throw.
+//***************************************************************************************
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    // workerCount = 0 creates one worker per hardware thread, minus the calling thread.
+    explicit ThreadPool( unsigned workerCount = 0 );
+    ThreadPool( const ThreadPool& rhs ) = delete;
+    ThreadPool& operator=( const ThreadPool& rhs ) = delete;
+    ~ThreadPool();
+
+    // Number of threads that execute a loop, including the calling thread.
+    unsigned GetThreadCount() const;
+
+    // Calls body( begin, end ) for consecutive ranges covering [0, count).
+    void ParallelFor( size_t count, size_t grainSize, const std::function<void( size_t, size_t )>& body );
+
+    // Process wide pool, created on first use.
+    static ThreadPool& Default();
+
+private:
+    struct Job
+    {
+        const std::function<void( size_t, size_t )>* Body = nullptr;
+
+        size_t              Count      = 0;
+        size_t              GrainSize  = 0;
+        size_t              ChunkCount = 0;
+        std::atomic<size_t> NextChunk { 0 };
+    };
+
+    void WorkerLoop();
+    static void RunChunks( Job& job );
+
+private:
+    std::vector<std::thread> mWorkers;
+
+    // Serializes loops issued from different threads.
+    std::mutex mSubmitMutex;
+
+    std::mutex              mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+
+    Job*          mJob         = nullptr;
+    std::uint64_t mGeneration  = 0;
+    unsigned      mBusyWorkers = 0;
+    bool          mQuit        = false;
+};
@@ -0,0 +1,239 @@
+//***************************************************************************************
+// TransformHierarchy.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "TransformHierarchy.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace DirectX;
+
+namespace
+{
+    // Levels smaller than this are updated on the calling thread.
+    const size_t ParallelGrainSize = 1024;
+} // namespace
+
+const TransformHierarchy::NodeId TransformHierarchy::InvalidNode;
+const std::uint32_t              TransformHierarchy::NoSlot;
+
+TransformHierarchy::NodeId TransformHierarchy::Create( NodeId parent )
+{
+    std::uint32_t parentSlot = NoSlot;
+    std::uint32_t depth      = 0;
+    if ( parent != InvalidNode )
+    {
+        parentSlot = GetSlot( parent );
+        assert( !IsRemoved( parentSlot ) );
+        depth = mDepth[parentSlot] + 1;
+    }
+
+    NodeId node;
+    if ( !mFreeNodes.empty() )
+    {
+        node = mFreeNodes.back();
+        mFreeNodes.pop_back();
+    }
+    else
+    {
+        node = (NodeId)mSlotOfNode.size();
+        mSlotOfNode.push_back( NoSlot );
+    }
+
+    // Appending keeps parents before children; Rebuild regroups the slots by depth.
+    mSlotOfNode[node] = (std::uint32_t)mNodeOfSlot.size();
+    mParentSlot.push_back( parentSlot );
+    mDepth.push_back( depth );
+    mNodeOfSlot.push_back( node );
+    mFlags.push_back( DirtyFlag );
+    mLocal.push_back( Affine3x4::Identity() );
+    mWorld.push_back( Affine3x4::Identity() );
+
+    mLayoutDirty = true;
+    mAnyDirty    = true;
+    return node;
+}
+
+void TransformHierarchy::Destroy( NodeId node )
+{
+    mFlags[GetSlot( node )] |= RemovedFlag;
+    mLayoutDirty = true;
+}
+
+void TransformHierarchy::SetLocal( NodeId node, FXMMATRIX local )
+{
+    SetLocal( node, Affine3x4( local ) );
+}
+
+void TransformHierarchy::SetLocal( NodeId node, const Affine3x4& local )
+{
+    std::uint32_t slot = GetSlot( node );
+    mLocal[slot]       = local;
+    mFlags[slot] |= DirtyFlag;
+    mAnyDirty = true;
+}
+
+TransformHierarchy::NodeId TransformHierarchy::GetParent( NodeId node ) const
+{
+    std::uint32_t parentSlot = mParentSlot[GetSlot( node )];
+    return parentSlot == NoSlot ? InvalidNode : mNodeOfSlot[parentSlot];
+}
+
+const Affine3x4& TransformHierarchy::GetLocal( NodeId node ) const
+{
+    return mLocal[GetSlot( node )];
+}
+
+const Affine3x4& TransformHierarchy::GetWorld( NodeId node ) const
+{
+    return mWorld[GetSlot( node )];
+}
+
+size_t TransformHierarchy::GetNodeCount() const
+{
+    return mNodeOfSlot.size();
+}
+
+const std::vector<TransformHierarchy::NodeId>& TransformHierarchy::GetChangedNodes() const
+{
+    return mChangedNodes;
+}
+
+std::uint32_t TransformHierarchy::GetSlot( NodeId node ) const
+{
+    assert( node < mSlotOfNode.size() && mSlotOfNode[node] != NoSlot );
+    return mSlotOfNode[node];
+}
+
+bool TransformHierarchy::IsRemoved( std::uint32_t slot ) const
+{
+    for ( ; slot != NoSlot; slot = mParentSlot[slot] )
+    {
+        if ( mFlags[slot] & RemovedFlag )
+            return true;
+    }
+    return false;
+}
+
+void TransformHierarchy::Update( ThreadPool& pool )
+{
+    if ( mLayoutDirty )
+        Rebuild();
+
+    mChangedNodes.clear();
+    if ( !mAnyDirty )
+        return;
+
+    // A level only reads the flags and world transforms of the level above, and each
+    // slot is written by exactly one thread, so the slots of a level need no locking.
+    for ( size_t level = 0; level + 1 < mLevelStart.size(); ++level )
+    {
+        size_t first = mLevelStart[level];
+        pool.ParallelFor( mLevelStart[level + 1] - first, ParallelGrainSize, [&]( size_t begin, size_t end ) {
+            for ( size_t slot = first + begin; slot < first + end; ++slot )
+            {
+                std::uint32_t parent = mParentSlot[slot];
+                if ( parent == NoSlot )
+                {
+                    if ( mFlags[slot] & DirtyFlag )
+                        mWorld[slot] = mLocal[slot];
+                }
+                else
+                {
+                    // Dirtiness propagates down: a moved parent moves all its children.
+                    mFlags[slot] |= mFlags[parent] & DirtyFlag;
+                    if ( mFlags[slot] & DirtyFlag )
+                        mWorld[slot] = Affine3x4::Multiply( mLocal[slot], mWorld[parent] );
+                }
+            }
+        } );
+    }
+
+    for ( size_t slot = 0; slot < mFlags.size(); ++slot )
+    {
+        if ( mFlags[slot] & DirtyFlag )
+        {
+            mChangedNodes.push_back( mNodeOfSlot[slot] );
+            mFlags[slot] &= ~DirtyFlag;
+        }
+    }
+
+    mAnyDirty = false;
+}
+
+void TransformHierarchy::Rebuild()
+{
+    size_t oldCount = mNodeOfSlot.size();
+
+    // Children of destroyed nodes are destroyed too.  Parents come first, so one pass
+    // propagates removal through whole subtrees.
+    std::uint32_t levelCount = 0;
+    for ( size_t slot = 0; slot < oldCount; ++slot )
+    {
+        std::uint32_t parent = mParentSlot[slot];
+        if ( parent != NoSlot && ( mFlags[parent] & RemovedFlag ) )
+            mFlags[slot] |= RemovedFlag;
+
+        if ( !( mFlags[slot] & RemovedFlag ) )
+            levelCount = std::max<std::uint32_t>( levelCount, mDepth[slot] + 1 );
+    }
+
+    // Counting sort by depth.  Being stable it keeps siblings in creation order.
+    mLevelStart.assign( levelCount + 1, 0 );
+    for ( size_t slot = 0; slot < oldCount; ++slot )
+    {
+        if ( !( mFlags[slot] & RemovedFlag ) )
+            ++mLevelStart[mDepth[slot] + 1];
+    }
+    for ( std::uint32_t level = 0; level < levelCount; ++level )
+        mLevelStart[level + 1] += mLevelStart[level];
+
+    size_t newCount = mLevelStart[levelCount];
+
+    std::vector<size_t>        next( mLevelStart.begin(), mLevelStart.end() - 1 );
+    std::vector<std::uint32_t> newSlot( oldCount, NoSlot );
+    for ( size_t slot = 0; slot < oldCount; ++slot )
+    {
+        if ( !( mFlags[slot] & RemovedFlag ) )
+            newSlot[slot] = (std::uint32_t)next[mDepth[slot]]++;
+    }
+
+    std::vector<std::uint32_t> parentSlot( newCount );
+    std::vector<std::uint32_t> depth( newCount );
+    std::vector<NodeId>        nodeOfSlot( newCount );
+    std::vector<std::uint8_t>  flags( newCount );
+    std::vector<Affine3x4>     local( newCount );
+    std::vector<Affine3x4>     world( newCount );
+
+    for ( size_t slot = 0; slot < oldCount; ++slot )
+    {
+        NodeId node = mNodeOfSlot[slot];
+        if ( mFlags[slot] & RemovedFlag )
+        {
+            mSlotOfNode[node] = NoSlot;
+            mFreeNodes.push_back( node );
+            continue;
+        }
+
+        std::uint32_t s   = newSlot[slot];
+        std::uint32_t p   = mParentSlot[slot];
+        parentSlot[s]     = p == NoSlot ? NoSlot : newSlot[p];
+        depth[s]          = mDepth[slot];
+        nodeOfSlot[s]     = node;
+        flags[s]          = mFlags[slot];
+        local[s]          = mLocal[slot];
+        world[s]          = mWorld[slot];
+        mSlotOfNode[node] = s;
+    }
+
+    mParentSlot.swap( parentSlot );
+    mDepth.swap( depth );
+    mNodeOfSlot.swap( nodeOfSlot );
+    mFlags.swap( flags );
+    mLocal.swap( local );
+    mWorld.swap( world );
+
+    mLayoutDirty = false;
+}
@@ -0,0 +1,92 @@
+//***************************************************************************************
+// TransformHierarchy.h
+//
+// Parent/child transform hierarchy that computes world matrices for a scene.
+//
+// Nodes are stored structure-of-arrays and sorted by depth, so every node's parent is
+// updated before it and all nodes of one depth can be updated in parallel.  Only nodes
+// whose local transform changed, and their descendants, are recomputed; a scene that
+// did not move costs nothing in Update().  GetChangedNodes() then lists exactly the
+// nodes whose world transform needs to be re-uploaded to the GPU.
+//
+// Transforms use the row-vector convention of DirectXMath: world = local * parentWorld.
+//***************************************************************************************
+
+#pragma once
+
+#include "Affine3x4.h"
+#include "ThreadPool.h"
+#include <cstdint>
+#include <vector>
+
+class TransformHierarchy
+{
+public:
+    using NodeId = std::uint32_t;
+
+    static const NodeId InvalidNode = 0xFFFFFFFF;
+
+    // Creates a node with an identity local transform.  parent must be a live node, not
+    // destroyed itself or through an ancestor, or InvalidNode for a root.
+    NodeId Create( NodeId parent = InvalidNode );
+
+    // Destroys node and all its descendants.  Their ids are recycled by the next Update.
+    void Destroy( NodeId node );
+
+    void SetLocal( NodeId node, DirectX::FXMMATRIX local );
+    void SetLocal( NodeId node, const Affine3x4& local );
+
+    NodeId           GetParent( NodeId node ) const;
+    const Affine3x4& GetLocal( NodeId node ) const;
+
+    // World transform as of the last Update.
+    const Affine3x4& GetWorld( NodeId node ) const;
+
+    size_t GetNodeCount() const;
+
+    // Recomputes the world transforms of changed nodes and their descendants.
+    void Update( ThreadPool& pool = ThreadPool::Default() );
+
+    // Nodes whose world transform was recomputed by the last Update, in depth order.
+    const std::vector<NodeId>& GetChangedNodes() const;
+
+private:
+    // Applies pending creations and destructions, restoring the depth ordering.
+    void Rebuild();
+
+    std::uint32_t GetSlot( NodeId node ) const;
+
+    // True if the node in slot or one of its ancestors was destroyed since the last
+    // Rebuild.  Walks up the hierarchy, so it is only used by asserts.
+    bool IsRemoved( std::uint32_t slot ) const;
+
+private:
+    static const std::uint32_t NoSlot = 0xFFFFFFFF;
+
+    enum : std::uint8_t
+    {
+        DirtyFlag   = 1,
+        RemovedFlag = 2
+    };
+
+    // Indexed by NodeId.
+    std::vector<std::uint32_t> mSlotOfNode;
+    std::vector<NodeId>        mFreeNodes;
+
+    // Indexed by slot.  Parents always come before their children; after Rebuild the
+    // slots are also grouped by depth.
+    std::vector<std::uint32_t> mParentSlot;
+    std::vector<std::uint32_t> mDepth;
+    std::vector<NodeId>        mNodeOfSlot;
+    std::vector<std::uint8_t>  mFlags;
+    std::vector<Affine3x4>     mLocal;
+    std::vector<Affine3x4>     mWorld;
+
+    // Slots [mLevelStart[d], mLevelStart[d+1]) hold the nodes of depth d.
+    std::vector<size_t> mLevelStart;
+
+    std::vector<NodeId> mChangedNodes;
+
+    bool mLayoutDirty = false;
+    bool mAnyDirty    = false;
+};
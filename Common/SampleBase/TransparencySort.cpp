@@ -0,0 +1,157 @@
+//***************************************************************************************
+// TransparencySort.cpp
+//***************************************************************************************
+
+#include "stdafx.h"
+
+#include "TransparencySort.h"
+#include <cfloat>
+
+using namespace DirectX;
+
+namespace
+{
+    struct ViewDirectionTable
+    {
+        XMFLOAT3 Directions[TransparencySort::NumViewDirections];
+
+        ViewDirectionTable()
+        {
+            // Every non-zero direction of the 3x3x3 cube lattice.
+            UINT n = 0;
+            for ( int z = -1; z <= 1; ++z )
+            {
+                for ( int y = -1; y <= 1; ++y )
+                {
+                    for ( int x = -1; x <= 1; ++x )
+                    {
+                        if ( x == 0 && y == 0 && z == 0 )
+                            continue;
+
+                        XMVECTOR d = XMVector3Normalize( XMVectorSet( (float)x, (float)y, (float)z, 0.0f ) );
+                        XMStoreFloat3( &Directions[n++], d );
+                    }
+                }
+            }
+        }
+    };
+
+    const ViewDirectionTable& GetDirectionTable()
+    {
+        static const ViewDirectionTable table;
+        return table;
+    }
+
+    template <typename IndexType>
+    void BuildOrderings(
+        const XMFLOAT3*         positions,
+        UINT                    positionStride,
+        std::vector<IndexType>& indices,
+        SubmeshGeometry&        submesh )
+    {
+        assert( submesh.IndexCount % 3 == 0 );
+        assert( submesh.StartIndexLocation + submesh.IndexCount <= indices.size() );
+
+        const UINT  triCount = submesh.IndexCount / 3;
+        const BYTE* vertices = reinterpret_cast<const BYTE*>( positions );
+
+        // Triangle centroids are shared by all orderings.
+        std::vector<XMFLOAT3> centroids( triCount );
+        for ( UINT t = 0; t < triCount; ++t )
+        {
+            XMVECTOR sum = XMVectorZero();
+            for ( UINT k = 0; k < 3; ++k )
+            {
+                size_t v = (size_t)submesh.BaseVertexLocation + indices[submesh.StartIndexLocation + t * 3 + k];
+                sum      = XMVectorAdd( sum, XMLoadFloat3( reinterpret_cast<const XMFLOAT3*>( vertices + v * positionStride ) ) );
+            }
+            XMStoreFloat3( &centroids[t], XMVectorScale( sum, 1.0f / 3.0f ) );
+        }
+
+        std::vector<std::pair<float, UINT>> keys( triCount );
+
+        submesh.ViewOrderStartIndices.resize( TransparencySort::NumViewDirections );
+        indices.reserve( indices.size() + (size_t)submesh.IndexCount * TransparencySort::NumViewDirections );
+
+        for ( UINT d = 0; d < TransparencySort::NumViewDirections; ++d )
+        {
+            XMVECTOR dir = XMLoadFloat3( &GetDirectionTable().Directions[d] );
+
+            for ( UINT t = 0; t < triCount; ++t )
+            {
+                keys[t].first  = XMVectorGetX( XMVector3Dot( XMLoadFloat3( &centroids[t] ), dir ) );
+                keys[t].second = t;
+            }
+
+            // Back-to-front: triangles farthest along the view direction come first.
+            std::stable_sort( keys.begin(), keys.end(), []( const std::pair<float, UINT>& a, const std::pair<float, UINT>& b ) {
+                return a.first > b.first;
+            } );
+
+            submesh.ViewOrderStartIndices[d] = (UINT)indices.size();
+            for ( UINT t = 0; t < triCount; ++t )
+            {
+                UINT src = submesh.StartIndexLocation + keys[t].second * 3;
+                indices.push_back( indices[src + 0] );
+                indices.push_back( indices[src + 1] );
+                indices.push_back( indices[src + 2] );
+            }
+        }
+    }
+} // namespace
+
+XMFLOAT3 TransparencySort::GetViewDirection( UINT i )
+{
+    assert( i < NumViewDirections );
+    return GetDirectionTable().Directions[i];
+}
+
+void TransparencySort::BuildViewOrderings(
+    const XMFLOAT3*             positions,
+    UINT                        positionStride,
+    std::vector<std::uint16_t>& indices,
+    SubmeshGeometry&            submesh )
+{
+    BuildOrderings( positions, positionStride, indices, submesh );
+}
+
+void TransparencySort::BuildViewOrderings(
+    const XMFLOAT3*             positions,
+    UINT                        positionStride,
+    std::vector<std::uint32_t>& indices,
+    SubmeshGeometry&            submesh )
+{
+    BuildOrderings( positions, positionStride, indices, submesh );
+}
+
+UINT TransparencySort::SelectViewDirection( FXMVECTOR localLook )
+{
+    const ViewDirectionTable& table = GetDirectionTable();
+
+    UINT  best    = 0;
+    float bestDot = -FLT_MAX;
+    for ( UINT i = 0; i < NumViewDirections; ++i )
+    {
+        float d = XMVectorGetX( XMVector3Dot( localLook, XMLoadFloat3( &table.Directions[i] ) ) );
+        if ( d > bestDot )
+        {
+            bestDot = d;
+            best    = i;
+        }
+    }
+
+    return best;
+}
+
+UINT TransparencySort::GetStartIndexLocation( const SubmeshGeometry& submesh, FXMVECTOR worldLook, CXMMATRIX world )
+{
+    if ( submesh.ViewOrderStartIndices.empty() )
+        return submesh.StartIndexLocation;
+
+    // Ordering by dot( p * world, look ) is ordering by dot( p, look * transpose( world ) ),
+    // so the look vector is brought into local space with the transpose rather than the
+    // inverse, which also holds under non-uniform scale.  Translation drops out.
+    XMVECTOR localLook = XMVector3TransformNormal( worldLook, XMMatrixTranspose( world ) );
+
+    return submesh.ViewOrderStartIndices[SelectViewDirection( localLook )];
+}
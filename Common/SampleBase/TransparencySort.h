@@ -0,0 +1,58 @@
+//***************************************************************************************
+// TransparencySort.h
+//
+// Precomputed per-view triangle orderings for transparent submeshes.
+//
+// Instead of sorting triangles back-to-front on the CPU every frame, each transparent
+// SubmeshGeometry stores NumViewDirections re-ordered copies of its indices, one per
+// quantized view direction (the 6 face, 12 edge and 8 corner directions of a cube).
+// At draw time the copy whose direction best matches the camera look vector is used
+// by passing its start location as the StartIndexLocation of the draw call.
+//
+// The ordering sorts triangle centroids along the view direction, which is exact for
+// parallel projections and a good approximation for perspective views of objects that
+// are small relative to their distance from the camera.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+
+class TransparencySort
+{
+public:
+    static const UINT NumViewDirections = 26;
+
+    // Returns the unit length view direction of ordering i.
+    static DirectX::XMFLOAT3 GetViewDirection( UINT i );
+
+    ///<summary>
+    /// Appends NumViewDirections sorted copies of the submesh's triangles to the end of
+    /// indices and records their start locations in submesh.ViewOrderStartIndices.
+    /// positions points at the first vertex of the vertex buffer the submesh draws from,
+    /// and positionStride is the vertex size in bytes.  Call this before creating the
+    /// GPU index buffer, and size MeshGeometry::IndexBufferByteSize from the grown vector.
+    ///</summary>
+    static void BuildViewOrderings(
+        const DirectX::XMFLOAT3*    positions,
+        UINT                        positionStride,
+        std::vector<std::uint16_t>& indices,
+        SubmeshGeometry&            submesh );
+
+    static void BuildViewOrderings(
+        const DirectX::XMFLOAT3*    positions,
+        UINT                        positionStride,
+        std::vector<std::uint32_t>& indices,
+        SubmeshGeometry&            submesh );
+
+    // Returns the ordering whose direction best matches a view direction given in the
+    // submesh's local space.
+    static UINT SelectViewDirection( DirectX::FXMVECTOR localLook );
+
+    ///<summary>
+    /// Returns the StartIndexLocation to draw the submesh with, given the camera look
+    /// vector (e.g. Camera::GetLook()) and the object's world matrix.  Falls back to the
+    /// submesh's own StartIndexLocation when no orderings were built.
+    ///</summary>
+    static UINT GetStartIndexLocation( const SubmeshGeometry& submesh, DirectX::FXMVECTOR worldLook, DirectX::CXMMATRIX world );
+};
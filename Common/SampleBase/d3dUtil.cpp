@@ -2,6 +2,7 @@
 #include "stdafx.h"
 
 #include "d3dUtil.h"
+#include "Profiler.h"
 #include <comdef.h>
 #include <fstream>
 
@@ -22,6 +23,8 @@ bool d3dUtil::IsKeyDown( int vkeyCode )
 
 ComPtr<ID3DBlob> d3dUtil::LoadBinary( const std::wstring& filename )
 {
+    PROFILE_SCOPE( "d3dUtil::LoadBinary" );
+
     std::ifstream fin( filename, std::ios::binary );
 
     fin.seekg( 0, std::ios_base::end );
@@ -93,6 +96,8 @@ ComPtr<ID3DBlob> d3dUtil::CompileShader(
     const std::string&      entrypoint,
     const std::string&      target )
 {
+    PROFILE_SCOPE( "d3dUtil::CompileShader" );
+
     UINT compileFlags = 0;
 #if defined( DEBUG ) || defined( _DEBUG )
     compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
@@ -154,6 +154,12 @@ struct SubmeshGeometry
     // Bounding box of the geometry defined by this submesh.
     // This is used in later chapters of the book.
     DirectX::BoundingBox Bounds;
+
+    // Optional back-to-front triangle orderings for transparent geometry.  When
+    // non-empty, entry i is the StartIndexLocation of an IndexCount-long copy of
+    // this submesh's indices sorted for the i-th quantized view direction.  The
+    // copies live in the same index buffer.  See TransparencySort.
+    std::vector<UINT> ViewOrderStartIndices;
 };
 
 struct MeshGeometry